@@ -6,8 +6,10 @@
 
 using cpr::Body;
 using cpr::Header;
+using cpr::ProgressCallback;
 using cpr::Timeout;
 using cpr::Url;
+using cpr::WriteCallback;
 using nlohmann::json;
 using std::cout;
 using std::endl;
@@ -24,7 +26,7 @@ AIAssistant::AIAssistant(const ConfigManager &config)
     // Constructor implementation
 }
 
-string AIAssistant::query_ollama(const string &prompt)
+string AIAssistant::query_ollama(const string &prompt, const atomic<bool> *cancel, const TokenCallback &on_token)
 {
     if (!ai_enabled)
     {
@@ -32,22 +34,36 @@ string AIAssistant::query_ollama(const string &prompt)
     }
     try
     {
+        bool stream = on_token && config.is_ai_streaming_enabled();
+
         // Prepare the JSON request for Ollama API
         json request_body = {
             {"model", config.get_model_name()},
             {"prompt", prompt},
-            {"stream", false},
+            {"stream", stream},
             {"options", {{"temperature", config.get_temperature()}, {"num_predict", config.get_max_tokens()}}}};
 
+        if (stream)
+        {
+            return query_ollama_stream(request_body.dump(), cancel, on_token);
+        }
+
         // Make the HTTP POST request to Ollama
         string endpoint = config.get_ollama_endpoint() + "/api/generate";
 
+        // Returning false from the progress callback aborts the transfer
         auto response = cpr::Post(
             Url{endpoint},
             Header{{"Content-Type", "application/json"}},
             Body{request_body.dump()},
-            Timeout{30000} // 30 second timeout
-        );
+            Timeout{30000}, // 30 second timeout
+            ProgressCallback{[cancel](auto, auto, auto, auto, intptr_t)
+                             { return cancel == nullptr || !cancel->load(); }});
+
+        if (cancel != nullptr && cancel->load())
+        {
+            return "Request cancelled.";
+        }
 
         if (response.status_code != 200)
         {
@@ -74,7 +90,119 @@ string AIAssistant::query_ollama(const string &prompt)
     }
 }
 
-string AIAssistant::get_task_suggestions(const Task &task)
+string AIAssistant::query_ollama_stream(const string &request_body, const atomic<bool> *cancel,
+                                        const TokenCallback &on_token)
+{
+    string endpoint = config.get_ollama_endpoint() + "/api/generate";
+    string pending; // Bytes of an NDJSON line not terminated yet
+    string full_response;
+    string error;
+    bool done = false;
+
+    // Parse one NDJSON chunk; returns false if Ollama reported an error
+    auto parse_line = [&](const string &line) -> bool
+    {
+        if (line.find_first_not_of(" \t\r") == string::npos)
+        {
+            return true;
+        }
+
+        auto chunk = json::parse(line, nullptr, false);
+        if (chunk.is_discarded())
+        {
+            return true;
+        }
+
+        if (chunk.contains("error"))
+        {
+            error = chunk["error"].get<string>();
+            return false;
+        }
+
+        if (chunk.contains("response"))
+        {
+            string piece = chunk["response"].get<string>();
+            if (!piece.empty())
+            {
+                full_response += piece;
+                on_token(piece);
+            }
+        }
+
+        done = chunk.value("done", false);
+        return true;
+    };
+
+    // Parse every complete line received so far; returns false to stop the transfer
+    auto consume = [&](auto data, intptr_t) -> bool
+    {
+        if (cancel != nullptr && cancel->load())
+        {
+            return false;
+        }
+
+        pending.append(data.data(), data.size());
+
+        size_t line_end;
+        while (!done && (line_end = pending.find('\n')) != string::npos)
+        {
+            string line = pending.substr(0, line_end);
+            pending.erase(0, line_end + 1);
+            if (!parse_line(line))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    // Generation can take long, so the timeout only covers connecting;
+    // a stalled stream is ended by the user cancelling
+    auto response = cpr::Post(
+        Url{endpoint},
+        Header{{"Content-Type", "application/json"}},
+        Body{request_body},
+        cpr::ConnectTimeout{5000},
+        WriteCallback{consume},
+        ProgressCallback{[cancel](auto, auto, auto, auto, intptr_t)
+                         { return cancel == nullptr || !cancel->load(); }});
+
+    if (cancel != nullptr && cancel->load())
+    {
+        return "Request cancelled.";
+    }
+
+    // The last chunk may end without a newline
+    if (!done && error.empty() && !pending.empty())
+    {
+        parse_line(pending);
+        pending.clear();
+    }
+
+    if (!error.empty())
+    {
+        return "Error from Ollama: " + error;
+    }
+
+    if (!done && response.status_code != 200)
+    {
+        return "Error: Unable to reach Ollama API (status " +
+               to_string(response.status_code) + "). " +
+               "Make sure Ollama is running on " + config.get_ollama_endpoint();
+    }
+
+    // The stream ended before Ollama marked the answer complete
+    if (!done)
+    {
+        string reason = response.error.message.empty() ? "connection closed" : response.error.message;
+        return full_response + "\n\n[Response truncated: " + reason + "]";
+    }
+
+    return full_response;
+}
+
+string AIAssistant::get_task_suggestions(const Task &task, const atomic<bool> *cancel, const TokenCallback &on_token)
 {
     if (!ai_enabled)
     {
@@ -97,10 +225,10 @@ string AIAssistant::get_task_suggestions(const Task &task)
 
     prompt << "\nPlease suggest specific, actionable next steps:";
 
-    return query_ollama(prompt.str());
+    return query_ollama(prompt.str(), cancel, on_token);
 }
 
-string AIAssistant::get_schedule_summary(const vector<Task> &tasks)
+string AIAssistant::get_schedule_summary(const vector<Task> &tasks, const atomic<bool> *cancel, const TokenCallback &on_token)
 {
     if (!ai_enabled)
     {
@@ -112,7 +240,7 @@ string AIAssistant::get_schedule_summary(const vector<Task> &tasks)
     prompt << "Here are the tasks to summarize:\n\n";
     prompt << format_tasks_for_ai(tasks);
     prompt << "\nPlease provide a concise summary and recommendations:";
-    return query_ollama(prompt.str());
+    return query_ollama(prompt.str(), cancel, on_token);
 }
 
 vector<string> AIAssistant::break_down_task(const Task &task)
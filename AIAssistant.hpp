@@ -1,13 +1,22 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <string>
 #include <vector>
 #include "Task.hpp"
 #include "ConfigManager.hpp"
 
+using std::atomic;
+using std::function;
 using std::string;
 using std::vector;
 
+/**
+ * @brief Receives response text as the model generates it
+ */
+using TokenCallback = function<void(const string &)>;
+
 /** AI Assistant interface
  * @brief Handles AI-powered task assistance using Ollama
  * This class provides methods to interact with a local Ollama instance
@@ -25,15 +34,21 @@ public:
     /**
      * @brief Get AI-generated suggestions for next steps on a task
      * @param task The task to analyze
+     * @param cancel Optional flag; setting it to true aborts the request
+     * @param on_token Optional callback receiving text as it streams in
      * @return AI-generated suggestions as a string
      */
-    string get_task_suggestions(const Task &task);
+    string get_task_suggestions(const Task &task, const atomic<bool> *cancel = nullptr,
+                                const TokenCallback &on_token = nullptr);
     /**
      * @brief Get a summary of the schedule
      * @param tasks Vector of tasks to summarize
+     * @param cancel Optional flag; setting it to true aborts the request
+     * @param on_token Optional callback receiving text as it streams in
      * @return AI-generated summary as a string
      */
-    string get_schedule_summary(const vector<Task> &tasks);
+    string get_schedule_summary(const vector<Task> &tasks, const atomic<bool> *cancel = nullptr,
+                                const TokenCallback &on_token = nullptr);
     /**
      * @brief Break down a complex task into smaller steps
      * @param task The task to break down
@@ -50,9 +65,26 @@ private:
     /**
      * @brief Send a request to the Ollama API
      * @param prompt The prompt to send
+     * @param cancel Optional flag; setting it to true aborts the request
+     * @param on_token Optional callback; when set and streaming is enabled,
+     *                 the response is requested as a stream and passed on chunk by chunk
      * @return The AI response, or error message
      */
-    string query_ollama(const string &prompt);
+    string query_ollama(const string &prompt, const atomic<bool> *cancel = nullptr,
+                        const TokenCallback &on_token = nullptr);
+
+    /**
+     * @brief Send a streaming request to the Ollama API
+     * Ollama answers with one JSON object per line; each carries the next
+     * piece of the response until one arrives with "done": true.
+     * @param request_body The request JSON (with "stream": true)
+     * @param cancel Optional flag; setting it to true aborts the request
+     * @param on_token Callback receiving each piece of the response
+     * @return The complete AI response, the partial one marked as truncated if the
+     *         stream ended before "done", or an error message
+     */
+    string query_ollama_stream(const string &request_body, const atomic<bool> *cancel,
+                               const TokenCallback &on_token);
     /**
      * @brief Format tasks into a readable string for the AI
      * @param tasks Vector of tasks to format
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+using std::string;
+
+/**
+ * @brief Where and how online backups of the database are written
+ * Small steps with a pause in between keep the backup from competing with
+ * the application for disk I/O.
+ */
+struct BackupSettings
+{
+    string directory = "backups"; // Created on the first backup
+    int keep = 7;                 // Newest backups kept, older ones are deleted (0 keeps all)
+    bool compress = true;         // zstd-compress the copy (needs a build with zstd)
+    int compression_level = 3;    // zstd level, 1 (fast) to 19 (small)
+    int pages_per_step = 256;     // Database pages copied per backup step
+    int step_pause_ms = 5;        // Pause between steps
+};
@@ -52,6 +52,10 @@ bool ConfigManager::load_config(const string &config_path)
             {
                 temperature = ai_config["temperature"].get<float>();
             }
+            if (ai_config.contains("stream"))
+            {
+                ai_streaming = ai_config["stream"].get<bool>();
+            }
         }
 
         // Load custom prompts
@@ -67,14 +71,102 @@ bool ConfigManager::load_config(const string &config_path)
             {
                 summary_prompt = prompts_config["summary"].get<string>();
             }
+        }
+
+        // Load database settings
+        if (config_json.contains("database"))
+        {
+            auto db_config = config_json["database"];
+            if (db_config.contains("path"))
+            {
+                database_path = db_config["path"].get<string>();
+            }
+
+            if (db_config.contains("read_connections"))
+            {
+                read_connections = db_config["read_connections"].get<int>();
+            }
+
+            if (db_config.contains("watch_interval_ms"))
+            {
+                watch_interval_ms = db_config["watch_interval_ms"].get<int>();
+            }
+
+            if (db_config.contains("archive"))
+            {
+                auto archive_config = db_config["archive"];
+
+                if (archive_config.contains("enabled"))
+                {
+                    archive_enabled = archive_config["enabled"].get<bool>();
+                }
+                if (archive_config.contains("path"))
+                {
+                    archive_path = archive_config["path"].get<string>();
+                }
+                if (archive_config.contains("after_days"))
+                {
+                    archive_after_days = archive_config["after_days"].get<int>();
+                }
+            }
+
+            if (db_config.contains("backup"))
+            {
+                auto backup_config = db_config["backup"];
+
+                if (backup_config.contains("directory"))
+                {
+                    backup_settings.directory = backup_config["directory"].get<string>();
+                }
+                if (backup_config.contains("keep"))
+                {
+                    backup_settings.keep = backup_config["keep"].get<int>();
+                }
+                if (backup_config.contains("compress"))
+                {
+                    backup_settings.compress = backup_config["compress"].get<bool>();
+                }
+                if (backup_config.contains("compression_level"))
+                {
+                    backup_settings.compression_level = backup_config["compression_level"].get<int>();
+                }
+                if (backup_config.contains("pages_per_step"))
+                {
+                    backup_settings.pages_per_step = backup_config["pages_per_step"].get<int>();
+                }
+                if (backup_config.contains("step_pause_ms"))
+                {
+                    backup_settings.step_pause_ms = backup_config["step_pause_ms"].get<int>();
+                }
+            }
 
-            // Load database settings
-            if (config_json.contains("database"))
+            if (db_config.contains("performance"))
             {
-                auto db_config = config_json["database"];
-                if (db_config.contains("path"))
+                auto performance_config = db_config["performance"];
+
+                if (performance_config.contains("journal_mode"))
+                {
+                    database_profile.journal_mode = performance_config["journal_mode"].get<string>();
+                }
+                if (performance_config.contains("synchronous"))
+                {
+                    database_profile.synchronous = performance_config["synchronous"].get<string>();
+                }
+                if (performance_config.contains("mmap_size"))
+                {
+                    database_profile.mmap_size = performance_config["mmap_size"].get<long long>();
+                }
+                if (performance_config.contains("cache_size"))
+                {
+                    database_profile.cache_size = performance_config["cache_size"].get<int>();
+                }
+                if (performance_config.contains("temp_store"))
+                {
+                    database_profile.temp_store = performance_config["temp_store"].get<string>();
+                }
+                if (performance_config.contains("busy_timeout_ms"))
                 {
-                    database_path = db_config["path"].get<string>();
+                    database_profile.busy_timeout_ms = performance_config["busy_timeout_ms"].get<int>();
                 }
             }
         }
@@ -4,6 +4,8 @@
 #include <string>
 #include <optional>
 #include <nlohmann/json.hpp>
+#include "BackupSettings.hpp"
+#include "SqliteProfile.hpp"
 
 using std::string;
 
@@ -53,6 +55,49 @@ public:
      */
     string get_database_path() const { return database_path; }
 
+    /**
+     * @brief Get the SQLite performance settings
+     * @return Pragmas to apply when the database is opened
+     */
+    SqliteProfile get_database_profile() const { return database_profile; }
+
+    /**
+     * @brief Get the size limit of the read connection pool
+     * @return Maximum read-only connections (0 = one per hardware thread)
+     */
+    int get_read_connections() const { return read_connections; }
+
+    /**
+     * @brief Get how often the database is checked for changes by other processes
+     * File events trigger a check sooner where the platform supports them.
+     * @return Interval in milliseconds (0 = do not watch)
+     */
+    int get_watch_interval_ms() const { return watch_interval_ms; }
+
+    /**
+     * @brief Check if completed tasks are moved to the archive database
+     * @return true if archiving is enabled, false otherwise
+     */
+    bool is_archive_enabled() const { return archive_enabled; }
+
+    /**
+     * @brief Get the archive database file path
+     * @return The archive database file path
+     */
+    string get_archive_path() const { return archive_path; }
+
+    /**
+     * @brief Get how long a completed task stays in the task list before it is archived
+     * @return Age in days since the task's last change
+     */
+    int get_archive_after_days() const { return archive_after_days; }
+
+    /**
+     * @brief Get the online backup settings
+     * @return Backup directory, rotation, compression and step size
+     */
+    BackupSettings get_backup_settings() const { return backup_settings; }
+
     /**
      * @brief Check if AI is enabled
      * @return true if AI is enabled, false otherwise
@@ -71,6 +116,12 @@ public:
      */
     float get_temperature() const { return temperature; }
 
+    /**
+     * @brief Check if AI responses should be streamed as they are generated
+     * @return true if streaming is enabled, false otherwise
+     */
+    bool is_ai_streaming_enabled() const { return ai_streaming; }
+
     /**
      * @brief Check if Redis is enabled
      * @return true if Redis is enabled, false otherwise
@@ -114,6 +165,7 @@ private:
     bool ai_enabled = true;
     int max_tokens = 1000;
     float temperature = 0.7f;
+    bool ai_streaming = true;
 
     // Custom prompts
     string task_suggestion_prompt =
@@ -128,6 +180,13 @@ private:
 
     // Database settings
     string database_path = "tasks.db";
+    SqliteProfile database_profile;
+    int read_connections = 0;
+    int watch_interval_ms = 2000;
+    bool archive_enabled = false;
+    string archive_path = "tasks_archive.db";
+    int archive_after_days = 180;
+    BackupSettings backup_settings;
 
     // Redin settings
     bool redis_enabled = false;
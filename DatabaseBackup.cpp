@@ -0,0 +1,441 @@
+#include "DatabaseBackup.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <sqlite3.h>
+
+#ifdef TEMINDER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using std::cerr;
+using std::endl;
+using std::exception;
+using std::lock_guard;
+using std::mutex;
+using std::vector;
+
+namespace fs = std::filesystem;
+
+// Suffix of files still being written; never counted as backups
+static const string PARTIAL_SUFFIX = ".partial";
+static const string COMPRESSED_SUFFIX = ".zst";
+
+// Inserted before the extension of a backup to name the archive copy taken with it
+static const string ARCHIVE_SUFFIX = ".archive";
+
+// Wait before retrying a step that found the database locked
+static const std::chrono::milliseconds LOCKED_RETRY_PAUSE(100);
+
+DatabaseBackup::DatabaseBackup(const string &db_path, const BackupSettings &settings, const string &archive_path)
+    : db_path(db_path), archive_path(archive_path), db_stem(fs::path(db_path).stem().string()),
+      db_extension(fs::path(db_path).extension().string()), settings(settings), running(false), cancel_requested(false)
+{
+    this->settings.pages_per_step = std::max(1, this->settings.pages_per_step);
+    this->settings.step_pause_ms = std::max(0, this->settings.step_pause_ms);
+}
+
+DatabaseBackup::~DatabaseBackup()
+{
+    cancel();
+}
+
+bool DatabaseBackup::start(ProgressCallback on_progress, DoneCallback on_done)
+{
+    lock_guard<mutex> lock(backup_mutex);
+    if (running)
+    {
+        return false;
+    }
+
+    // The previous backup has finished; only its thread is left to join
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+
+    running = true;
+    cancel_requested = false;
+    worker = std::thread([this, on_progress, on_done]
+                         { run(on_progress, on_done); });
+    return true;
+}
+
+bool DatabaseBackup::is_running() const
+{
+    lock_guard<mutex> lock(backup_mutex);
+    return running;
+}
+
+void DatabaseBackup::cancel()
+{
+    cancel_requested = true;
+
+    std::thread finished;
+    {
+        lock_guard<mutex> lock(backup_mutex);
+        finished = std::move(worker);
+    }
+    if (finished.joinable())
+    {
+        finished.join();
+    }
+}
+
+bool DatabaseBackup::compression_available()
+{
+#ifdef TEMINDER_HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+void DatabaseBackup::run(ProgressCallback on_progress, DoneCallback on_done)
+{
+    string result;
+    bool ok = create_backup(on_progress, result);
+
+    {
+        lock_guard<mutex> lock(backup_mutex);
+        running = false;
+    }
+
+    if (on_done)
+    {
+        try
+        {
+            on_done(ok, result);
+        }
+        catch (const exception &e)
+        {
+            cerr << "Error in backup callback: " << e.what() << endl;
+        }
+    }
+}
+
+bool DatabaseBackup::create_backup(const ProgressCallback &on_progress, string &result)
+{
+    string target = next_backup_path();
+    bool compress = settings.compress && compression_available();
+
+    // The archive holds tasks moved out of the database; a backup without it loses them
+    vector<string> targets = {target};
+    if (!archive_path.empty() && fs::exists(archive_path))
+    {
+        targets.push_back(archive_companion(target));
+    }
+
+    // Leftovers of a failed or cancelled backup
+    auto remove_partials = [&]()
+    {
+        std::error_code ignored;
+        for (const auto &file : targets)
+        {
+            string partial = file + PARTIAL_SUFFIX;
+            for (const char *suffix : {"", "-journal", "-wal", "-shm"})
+            {
+                fs::remove(partial + suffix, ignored);
+            }
+            fs::remove(file + COMPRESSED_SUFFIX + PARTIAL_SUFFIX, ignored);
+        }
+    };
+
+    try
+    {
+        fs::create_directories(settings.directory);
+
+        if (!copy_database(target + PARTIAL_SUFFIX, targets.size() > 1 ? targets[1] + PARTIAL_SUFFIX : "", on_progress))
+        {
+            remove_partials();
+            result = "Backup cancelled";
+            return false;
+        }
+
+        if (compress)
+        {
+            for (const auto &file : targets)
+            {
+                if (!compress_file(file + PARTIAL_SUFFIX, file + COMPRESSED_SUFFIX + PARTIAL_SUFFIX, on_progress))
+                {
+                    remove_partials();
+                    result = cancel_requested ? "Backup cancelled" : "Compressing backup failed";
+                    return false;
+                }
+            }
+        }
+
+        // Both files are complete: only now do they take their final names
+        for (const auto &file : targets)
+        {
+            if (compress)
+            {
+                fs::rename(file + COMPRESSED_SUFFIX + PARTIAL_SUFFIX, file + COMPRESSED_SUFFIX);
+                fs::remove(file + PARTIAL_SUFFIX);
+            }
+            else
+            {
+                fs::rename(file + PARTIAL_SUFFIX, file);
+            }
+        }
+        if (compress)
+        {
+            target += COMPRESSED_SUFFIX;
+        }
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error backing up database: " << e.what() << endl;
+        remove_partials();
+        result = e.what();
+        return false;
+    }
+
+    rotate_backups();
+    result = target;
+    return true;
+}
+
+bool DatabaseBackup::copy_database(const string &target, const string &archive_target, const ProgressCallback &on_progress)
+{
+    SQLite::Database source(db_path, SQLite::OPEN_READONLY);
+    source.setBusyTimeout(5000);
+    if (!archive_target.empty())
+    {
+        SQLite::Statement attach(source, "ATTACH DATABASE ? AS archive");
+        attach.bind(1, archive_path);
+        attach.exec();
+    }
+
+    // In WAL mode an open read transaction pins one snapshot for every step, so
+    // commits by the application neither restart the copy nor block on it. Other
+    // journal modes would hold off writers for the whole copy, so there each step
+    // takes its own short read lock and a commit restarts the copy.
+    auto journal_mode = [&](const string &schema)
+    {
+        SQLite::Statement query(source, "PRAGMA " + schema + ".journal_mode");
+        return query.executeStep() ? string(query.getColumn(0).getText()) : string();
+    };
+    bool pinned = journal_mode("main") == "wal";
+    bool archive_pinned = pinned && !archive_target.empty() && journal_mode("archive") == "wal";
+    if (pinned)
+    {
+        // Tasks are copied to the archive before they leave the database, so a database
+        // snapshot taken no later than the archive's never misses an archived task
+        source.exec("BEGIN");
+        SQLite::Statement start(source, "SELECT count(*) FROM main.sqlite_master");
+        start.executeStep();
+        if (archive_pinned)
+        {
+            SQLite::Statement start_archive(source, "SELECT count(*) FROM archive.sqlite_master");
+            start_archive.executeStep();
+        }
+    }
+
+    // Without a pinned snapshot the archive is still copied second, so it is the later of the two
+    if (!copy_schema(source, "main", target, "Copying", on_progress) ||
+        (!archive_target.empty() && !copy_schema(source, "archive", archive_target, "Copying archive", on_progress)))
+    {
+        return false;
+    }
+
+    if (pinned)
+    {
+        source.exec("COMMIT");
+    }
+    return true;
+}
+
+bool DatabaseBackup::copy_schema(SQLite::Database &source, const string &schema, const string &target,
+                                 const string &stage, const ProgressCallback &on_progress)
+{
+    SQLite::Database destination(target, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+
+    int last_percent = -1;
+    {
+        SQLite::Backup backup(destination, "main", source, schema.c_str());
+        while (true)
+        {
+            if (cancel_requested)
+            {
+                return false;
+            }
+
+            int status = backup.executeStep(settings.pages_per_step);
+            int total = backup.getTotalPageCount();
+            int percent = total > 0 ? static_cast<int>(100LL * (total - backup.getRemainingPageCount()) / total) : 100;
+            if (on_progress && percent != last_percent)
+            {
+                on_progress(stage, percent);
+                last_percent = percent;
+            }
+
+            if (status == SQLITE_DONE)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(status == SQLITE_OK ? std::chrono::milliseconds(settings.step_pause_ms) : LOCKED_RETRY_PAUSE);
+        }
+    }
+
+    // The copy inherits WAL mode from the header; a rollback journal keeps it a single self-contained file
+    destination.exec("PRAGMA journal_mode = DELETE");
+    return true;
+}
+
+bool DatabaseBackup::compress_file(const string &source, const string &target, const ProgressCallback &on_progress)
+{
+#ifdef TEMINDER_HAVE_ZSTD
+    std::ifstream input(source, std::ios::binary);
+    std::ofstream output(target, std::ios::binary | std::ios::trunc);
+    if (!input || !output)
+    {
+        cerr << "Error opening backup files for compression: " << source << endl;
+        return false;
+    }
+
+    std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx *)> context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+    if (!context)
+    {
+        cerr << "Error creating zstd context" << endl;
+        return false;
+    }
+
+    uintmax_t total = fs::file_size(source);
+    ZSTD_CCtx_setParameter(context.get(), ZSTD_c_compressionLevel, settings.compression_level);
+    ZSTD_CCtx_setParameter(context.get(), ZSTD_c_checksumFlag, 1);
+    ZSTD_CCtx_setPledgedSrcSize(context.get(), total);
+
+    vector<char> in_buffer(ZSTD_CStreamInSize());
+    vector<char> out_buffer(ZSTD_CStreamOutSize());
+    uintmax_t done = 0;
+    int last_percent = -1;
+
+    while (true)
+    {
+        if (cancel_requested)
+        {
+            return false;
+        }
+
+        input.read(in_buffer.data(), static_cast<std::streamsize>(in_buffer.size()));
+        size_t read = static_cast<size_t>(input.gcount());
+        bool last_chunk = read < in_buffer.size();
+        ZSTD_EndDirective mode = last_chunk ? ZSTD_e_end : ZSTD_e_continue;
+
+        // Drain the output until this chunk is consumed (or, at the end, the frame is complete)
+        ZSTD_inBuffer chunk = {in_buffer.data(), read, 0};
+        bool finished;
+        do
+        {
+            ZSTD_outBuffer out = {out_buffer.data(), out_buffer.size(), 0};
+            size_t remaining = ZSTD_compressStream2(context.get(), &out, &chunk, mode);
+            if (ZSTD_isError(remaining))
+            {
+                cerr << "Error compressing backup: " << ZSTD_getErrorName(remaining) << endl;
+                return false;
+            }
+            output.write(out_buffer.data(), static_cast<std::streamsize>(out.pos));
+            finished = last_chunk ? remaining == 0 : chunk.pos == chunk.size;
+        } while (!finished);
+
+        done += read;
+        int percent = total > 0 ? static_cast<int>(100 * done / total) : 100;
+        if (on_progress && percent != last_percent)
+        {
+            on_progress("Compressing", percent);
+            last_percent = percent;
+        }
+
+        if (last_chunk)
+        {
+            break;
+        }
+    }
+
+    output.close();
+    if (!output)
+    {
+        cerr << "Error writing compressed backup: " << target << endl;
+        return false;
+    }
+    return true;
+#else
+    (void)source;
+    (void)target;
+    (void)on_progress;
+    return false;
+#endif
+}
+
+void DatabaseBackup::rotate_backups()
+{
+    if (settings.keep <= 0)
+    {
+        return;
+    }
+
+    try
+    {
+        // Names embed the time, so they sort oldest first
+        string prefix = db_stem + "-";
+        vector<fs::path> backups;
+        for (const auto &entry : fs::directory_iterator(settings.directory))
+        {
+            // Strip the compression suffix and the extension to get the name of one backup
+            fs::path name = entry.path().filename();
+            if (name.extension() == COMPRESSED_SUFFIX)
+            {
+                name = name.stem();
+            }
+            bool is_backup = name.string().compare(0, prefix.size(), prefix) == 0 && name.extension() == db_extension &&
+                             name.stem().extension() != ARCHIVE_SUFFIX;
+            if (entry.is_regular_file() && is_backup)
+            {
+                backups.push_back(entry.path());
+            }
+        }
+
+        // An archive copy goes with the backup it was taken with
+        std::sort(backups.begin(), backups.end());
+        size_t keep = static_cast<size_t>(settings.keep);
+        for (size_t i = 0; i + keep < backups.size(); ++i)
+        {
+            bool compressed = backups[i].extension() == COMPRESSED_SUFFIX;
+            string backup = compressed ? (backups[i].parent_path() / backups[i].stem()).string() : backups[i].string();
+            fs::remove(backups[i]);
+            fs::remove(archive_companion(backup) + (compressed ? COMPRESSED_SUFFIX : ""));
+        }
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error rotating backups: " << e.what() << endl;
+    }
+}
+
+string DatabaseBackup::archive_companion(const string &backup_path) const
+{
+    // tasks-20250102-030405-678.db -> tasks-20250102-030405-678.archive.db
+    fs::path path(backup_path);
+    return (path.parent_path() / (path.stem().string() + ARCHIVE_SUFFIX + db_extension)).string();
+}
+
+string DatabaseBackup::next_backup_path() const
+{
+    auto now = std::chrono::system_clock::now();
+    time_t seconds = std::chrono::system_clock::to_time_t(now);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+
+    std::ostringstream name;
+    name << db_stem << "-" << std::put_time(std::localtime(&seconds), "%Y%m%d-%H%M%S")
+         << "-" << std::setw(3) << std::setfill('0') << millis << db_extension;
+    return (fs::path(settings.directory) / name.str()).string();
+}
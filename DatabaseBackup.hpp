@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <SQLiteCpp/Database.h>
+#include "BackupSettings.hpp"
+
+using std::function;
+using std::string;
+
+/**
+ * @brief Online backup of the database with the SQLite backup API
+ * A background thread copies the database a few pages at a time through its
+ * own read-only connection, so the application keeps reading and writing.
+ * In WAL mode the copy is taken from one snapshot: commits made meanwhile are
+ * neither copied nor make the backup start over. The archive database, if
+ * there is one, is copied alongside into a companion file. The copies are
+ * optionally compressed with zstd, and old backups are rotated out.
+ */
+class DatabaseBackup
+{
+public:
+    /**
+     * @brief Reports progress: the current stage ("Copying", "Compressing") and its percentage
+     */
+    using ProgressCallback = function<void(const string &, int)>;
+
+    /**
+     * @brief Called when a backup ends: success, and the backup file or the error
+     */
+    using DoneCallback = function<void(bool, const string &)>;
+
+    /**
+     * @brief Prepare backups of a database; nothing runs until start()
+     * @param db_path The database file
+     * @param settings Target directory, rotation, compression and step size
+     * @param archive_path The archive database of completed tasks; empty if there is none
+     */
+    DatabaseBackup(const string &db_path, const BackupSettings &settings = BackupSettings(), const string &archive_path = "");
+
+    /**
+     * @brief Cancel a running backup and wait for its thread
+     */
+    ~DatabaseBackup();
+
+    DatabaseBackup(const DatabaseBackup &) = delete;
+    DatabaseBackup &operator=(const DatabaseBackup &) = delete;
+
+    /**
+     * @brief Start a backup on a background thread
+     * @param on_progress Optional progress callback, run on the backup thread
+     * @param on_done Optional completion callback, run on the backup thread
+     * @return false if a backup is already running
+     */
+    bool start(ProgressCallback on_progress = nullptr, DoneCallback on_done = nullptr);
+
+    /**
+     * @brief Check whether a backup is running
+     * @return true between start() and the completion callback
+     */
+    bool is_running() const;
+
+    /**
+     * @brief Stop a running backup and wait for its thread; the partial copy is removed
+     */
+    void cancel();
+
+    /**
+     * @brief Write a backup on the calling thread
+     * @param on_progress Optional progress callback
+     * @param result Receives the path of the backup file, or the error
+     * @return true if the backup was written
+     */
+    bool create_backup(const ProgressCallback &on_progress, string &result);
+
+    /**
+     * @brief Check whether this build can compress backups
+     * @return true if built with zstd (TEMINDER_HAVE_ZSTD)
+     */
+    static bool compression_available();
+
+private:
+    /**
+     * @brief Backup thread: run create_backup and report the result
+     */
+    void run(ProgressCallback on_progress, DoneCallback on_done);
+
+    /**
+     * @brief Copy the database, and the archive if given, into new files with the backup API
+     * @param target The file to create for the database
+     * @param archive_target The file to create for the archive; empty to skip it
+     * @param on_progress Optional progress callback
+     * @return true if every page was copied
+     * @throws SQLite::Exception on database errors
+     */
+    bool copy_database(const string &target, const string &archive_target, const ProgressCallback &on_progress);
+
+    /**
+     * @brief Copy one schema of the source connection into a new file, a few pages per step
+     * @param source Connection with the schema attached
+     * @param schema "main" or "archive"
+     * @param target The file to create
+     * @param stage Stage name reported to on_progress
+     * @param on_progress Optional progress callback
+     * @return true if every page was copied, false if cancelled
+     */
+    bool copy_schema(SQLite::Database &source, const string &schema, const string &target,
+                     const string &stage, const ProgressCallback &on_progress);
+
+    /**
+     * @brief Compress a file with streaming zstd
+     * @param source The file to compress
+     * @param target The compressed file to create
+     * @param on_progress Optional progress callback
+     * @return true if the compressed file was written
+     */
+    bool compress_file(const string &source, const string &target, const ProgressCallback &on_progress);
+
+    /**
+     * @brief Delete all but the newest settings.keep backups, with their archive copies
+     */
+    void rotate_backups();
+
+    /**
+     * @brief Build the path of the archive copy that belongs to a backup
+     * @param backup_path Uncompressed path of the database backup
+     * @return e.g. backups/tasks-20250102-030405-678.archive.db
+     */
+    string archive_companion(const string &backup_path) const;
+
+    /**
+     * @brief Build the path of a new backup file from the current time
+     * @return e.g. backups/tasks-20250102-030405-678.db
+     */
+    string next_backup_path() const;
+
+    string db_path;
+    string archive_path;
+    string db_stem;      // Database file name without extension; prefix of every backup
+    string db_extension; // Extension of the database file, kept by the backups
+    BackupSettings settings;
+
+    mutable std::mutex backup_mutex;
+    bool running;
+    std::atomic<bool> cancel_requested;
+    std::thread worker;
+};
@@ -0,0 +1,512 @@
+#include "DatabaseManager.hpp"
+#include "ReadConnectionPool.hpp"
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::exception;
+using std::function;
+using std::mt19937;
+using std::optional;
+using std::setw;
+using std::string;
+using std::stringstream;
+using std::to_string;
+using std::uniform_int_distribution;
+using std::uniform_real_distribution;
+using std::vector;
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Shape of the synthetic data set
+ */
+struct BenchOptions
+{
+    vector<int> task_counts = {10000, 100000, 1000000};
+    int fanout = 3;               // Subtasks per top-level task
+    int links_per_task = 1;       // Links attached to every task
+    int tags_per_task = 1;        // Tags attached to every task, drawn from tag_pool
+    int tag_pool = 16;            // Distinct tags in the data set
+    double completed_ratio = 0.3; // Fraction of tasks marked completed
+    int iterations = 200;         // Repetitions of each point operation
+    int scan_iterations = 5;      // Repetitions of each full-table operation
+    int batch_size = 1000;        // Tasks per add_tasks call
+    int readers = 4;              // Threads in the concurrent read test (0 = skip)
+    unsigned seed = 42;
+    string directory = fs::temp_directory_path().string();
+    bool keep = false; // Keep the database files after the run
+};
+
+/**
+ * @brief Latency samples of one operation
+ */
+struct BenchResult
+{
+    string name;
+    vector<double> samples_ms;
+};
+
+static void print_usage()
+{
+    cout << "Usage: teminder_bench [options]\n"
+         << "  --tasks N[,N...]    Task counts to benchmark (default 10000,100000,1000000)\n"
+         << "  --fanout N          Subtasks per top-level task (default 3)\n"
+         << "  --links N           Links per task (default 1)\n"
+         << "  --tags N            Tags per task, from a pool of 16 (default 1)\n"
+         << "  --completed R       Fraction of completed tasks, 0..1 (default 0.3)\n"
+         << "  --iterations N      Repetitions of point operations (default 200)\n"
+         << "  --scan-iterations N Repetitions of full-table operations (default 5)\n"
+         << "  --batch N           Tasks per add_tasks batch (default 1000)\n"
+         << "  --readers N         Threads for the concurrent read test, 0 to skip (default 4)\n"
+         << "  --seed N            Random seed (default 42)\n"
+         << "  --dir PATH          Directory for the temporary databases\n"
+         << "  --keep              Keep the generated databases\n";
+}
+
+static bool parse_options(int argc, char **argv, BenchOptions &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        auto next = [&]() -> string
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--tasks")
+        {
+            options.task_counts.clear();
+            stringstream list(next());
+            string item;
+            while (getline(list, item, ','))
+            {
+                options.task_counts.push_back(std::stoi(item));
+            }
+        }
+        else if (arg == "--fanout")
+            options.fanout = std::stoi(next());
+        else if (arg == "--links")
+            options.links_per_task = std::stoi(next());
+        else if (arg == "--tags")
+            options.tags_per_task = std::stoi(next());
+        else if (arg == "--completed")
+            options.completed_ratio = std::stod(next());
+        else if (arg == "--iterations")
+            options.iterations = std::stoi(next());
+        else if (arg == "--scan-iterations")
+            options.scan_iterations = std::stoi(next());
+        else if (arg == "--batch")
+            options.batch_size = std::stoi(next());
+        else if (arg == "--readers")
+            options.readers = std::stoi(next());
+        else if (arg == "--seed")
+            options.seed = static_cast<unsigned>(std::stoul(next()));
+        else if (arg == "--dir")
+            options.directory = next();
+        else if (arg == "--keep")
+            options.keep = true;
+        else if (arg == "--help" || arg == "-h")
+        {
+            print_usage();
+            return false;
+        }
+        else
+        {
+            throw std::invalid_argument("unknown option " + arg);
+        }
+    }
+
+    // Lookups draw task IDs from 1..count, so every run needs at least one task
+    if (options.task_counts.empty())
+    {
+        throw std::invalid_argument("--tasks needs at least one count");
+    }
+    for (int count : options.task_counts)
+    {
+        if (count < 1)
+        {
+            throw std::invalid_argument("task count must be at least 1, got " + to_string(count));
+        }
+    }
+    if (options.fanout < 0)
+    {
+        throw std::invalid_argument("--fanout must not be negative");
+    }
+    if (options.batch_size < 1)
+    {
+        throw std::invalid_argument("--batch must be at least 1");
+    }
+    if (options.iterations < 1 || options.scan_iterations < 1)
+    {
+        throw std::invalid_argument("--iterations and --scan-iterations must be at least 1");
+    }
+    return true;
+}
+
+static void remove_database(const string &path)
+{
+    for (const char *suffix : {"", "-wal", "-shm", "-journal"})
+    {
+        std::error_code ignored;
+        fs::remove(path + suffix, ignored);
+    }
+}
+
+/**
+ * @brief Make a random task; parent_id is filled in by the caller
+ */
+static Task make_task(mt19937 &rng, const BenchOptions &options, int number)
+{
+    uniform_int_distribution<int> priority(0, 2);
+    uniform_int_distribution<int> due_offset(-30 * 86400, 30 * 86400);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+
+    Task task;
+    task.description = "Benchmark task " + to_string(number);
+    task.priority = priority(rng);
+    if (unit(rng) < 0.8)
+    {
+        task.due_date = time(nullptr) + due_offset(rng);
+    }
+    task.is_completed = unit(rng) < options.completed_ratio;
+    task.status = task.is_completed ? 4 : 0;
+    task.progress = task.is_completed ? 100 : 0;
+    for (int l = 0; l < options.links_per_task; ++l)
+    {
+        task.links.push_back("https://example.com/task/" + to_string(number) + "/" + to_string(l));
+    }
+
+    // Tag IDs 1..tag_pool are created by generate_tasks
+    uniform_int_distribution<int> tag(1, std::max(1, options.tag_pool));
+    for (int t = 0; t < options.tags_per_task; ++t)
+    {
+        int tag_id = tag(rng);
+        if (std::find(task.tags.begin(), task.tags.end(), tag_id) == task.tags.end())
+        {
+            task.tags.push_back(tag_id);
+        }
+    }
+    return task;
+}
+
+/**
+ * @brief Fill the database with synthetic tasks
+ * Writes through a separate connection in one transaction so that
+ * generating a million rows takes seconds rather than hours.
+ * @return IDs of the top-level tasks
+ */
+static vector<int> generate_tasks(const string &path, int count, const BenchOptions &options, mt19937 &rng)
+{
+    SQLite::Database db(path, SQLite::OPEN_READWRITE);
+    SQLite::Transaction transaction(db);
+    SQLite::Statement insert_task(db,
+                                  "INSERT INTO tasks (description, is_completed, priority, created_at, due_date, parent_id, progress, status) "
+                                  "VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+    SQLite::Statement insert_link(db, "INSERT INTO task_links (task_id, link) VALUES (?, ?)");
+    SQLite::Statement insert_task_tag(db, "INSERT INTO task_tags (task_id, tag_id) VALUES (?, ?)");
+
+    for (int t = 1; t <= options.tag_pool; ++t)
+    {
+        SQLite::Statement insert_tag(db, "INSERT INTO tags (id, name) VALUES (?, ?)");
+        insert_tag.bind(1, t);
+        insert_tag.bind(2, "tag" + to_string(t));
+        insert_tag.exec();
+    }
+
+    vector<int> parent_ids;
+    int current_parent = 0;
+    int children_left = 0;
+
+    for (int n = 0; n < count; ++n)
+    {
+        Task task = make_task(rng, options, n);
+        if (children_left > 0)
+        {
+            task.parent_id = current_parent;
+        }
+
+        insert_task.bind(1, task.description);
+        insert_task.bind(2, task.is_completed ? 1 : 0);
+        insert_task.bind(3, task.priority);
+        insert_task.bind(4, static_cast<int64_t>(task.created_at));
+        if (task.due_date.has_value())
+            insert_task.bind(5, static_cast<int64_t>(task.due_date.value()));
+        else
+            insert_task.bind(5);
+        if (task.parent_id.has_value())
+            insert_task.bind(6, task.parent_id.value());
+        else
+            insert_task.bind(6);
+        insert_task.bind(7, task.progress);
+        insert_task.bind(8, task.status);
+        insert_task.exec();
+        insert_task.reset();
+
+        int id = static_cast<int>(db.getLastInsertRowid());
+        for (const auto &link : task.links)
+        {
+            insert_link.bind(1, id);
+            insert_link.bind(2, link);
+            insert_link.exec();
+            insert_link.reset();
+        }
+        for (int tag_id : task.tags)
+        {
+            insert_task_tag.bind(1, id);
+            insert_task_tag.bind(2, tag_id);
+            insert_task_tag.exec();
+            insert_task_tag.reset();
+        }
+
+        if (children_left > 0)
+        {
+            children_left--;
+        }
+        else
+        {
+            current_parent = id;
+            children_left = options.fanout;
+            parent_ids.push_back(id);
+        }
+    }
+
+    transaction.commit();
+    return parent_ids;
+}
+
+static BenchResult measure(const string &name, int iterations, const function<void(int)> &operation)
+{
+    BenchResult result{name, {}};
+    result.samples_ms.reserve(iterations);
+    for (int i = 0; i < iterations; ++i)
+    {
+        auto start = Clock::now();
+        operation(i);
+        auto end = Clock::now();
+        result.samples_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return result;
+}
+
+static double percentile(vector<double> sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static void print_results(const vector<BenchResult> &results)
+{
+    cout << std::left << setw(28) << "operation" << std::right
+         << setw(10) << "runs" << setw(14) << "ops/s"
+         << setw(12) << "p50 ms" << setw(12) << "p99 ms" << "\n";
+
+    for (const auto &result : results)
+    {
+        double total_ms = 0.0;
+        for (double sample : result.samples_ms)
+        {
+            total_ms += sample;
+        }
+        double ops = total_ms > 0.0 ? result.samples_ms.size() * 1000.0 / total_ms : 0.0;
+
+        cout << std::left << setw(28) << result.name << std::right
+             << setw(10) << result.samples_ms.size()
+             << setw(14) << std::fixed << std::setprecision(1) << ops
+             << setw(12) << std::setprecision(3) << percentile(result.samples_ms, 0.50)
+             << setw(12) << percentile(result.samples_ms, 0.99) << "\n";
+    }
+    cout << std::defaultfloat << endl;
+}
+
+/**
+ * @brief Measure aggregate get_task_by_id throughput of threads sharing a read pool
+ * @param path The database file
+ * @param task_count Highest task id to look up
+ * @param readers Number of threads, each holding one pooled connection
+ * @param lookups Lookups per thread
+ * @param seed Base random seed
+ * @return Lookups per second over all threads
+ */
+static double measure_parallel_reads(const string &path, int task_count, int readers, int lookups, unsigned seed)
+{
+    ReadConnectionPool pool(path, SqliteProfile(), static_cast<size_t>(readers));
+
+    // Open and warm every connection first, so the clock only sees lookups
+    vector<ReadConnectionPool::Lease> connections;
+    connections.reserve(readers);
+    for (int r = 0; r < readers; ++r)
+    {
+        connections.push_back(pool.acquire());
+        connections.back()->get_task_by_id(1);
+    }
+
+    // The threads start together once the clock is running
+    std::promise<void> start_signal;
+    std::shared_future<void> started = start_signal.get_future().share();
+    vector<std::thread> threads;
+    threads.reserve(readers);
+    for (int r = 0; r < readers; ++r)
+    {
+        threads.emplace_back([&, r]()
+                             {
+            mt19937 thread_rng(seed + static_cast<unsigned>(r));
+            uniform_int_distribution<int> any_task(1, task_count);
+            DatabaseManager &connection = *connections[r];
+            started.wait();
+            for (int i = 0; i < lookups; ++i)
+            {
+                connection.get_task_by_id(any_task(thread_rng));
+            } });
+    }
+
+    auto start = Clock::now();
+    start_signal.set_value();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    return seconds > 0.0 ? readers * static_cast<double>(lookups) / seconds : 0.0;
+}
+
+static void run_benchmark(int task_count, const BenchOptions &options)
+{
+    string path = (fs::path(options.directory) / ("teminder_bench_" + to_string(task_count) + ".db")).string();
+    remove_database(path);
+
+    mt19937 rng(options.seed);
+    vector<int> parent_ids;
+    {
+        DatabaseManager schema(path);
+        schema.initilize_database();
+    }
+
+    auto generate_start = Clock::now();
+    parent_ids = generate_tasks(path, task_count, options, rng);
+    double generate_s = std::chrono::duration<double>(Clock::now() - generate_start).count();
+
+    cout << "== " << task_count << " tasks (fan-out " << options.fanout << ", "
+         << options.links_per_task << " links/task, " << options.tags_per_task << " tags/task, " << options.completed_ratio * 100 << "% completed) ==\n"
+         << "generated in " << std::fixed << std::setprecision(2) << generate_s << " s\n"
+         << std::defaultfloat;
+
+    DatabaseManager db(path);
+    vector<BenchResult> results;
+    uniform_int_distribution<int> any_task(1, task_count);
+    uniform_int_distribution<size_t> any_parent(0, parent_ids.empty() ? 0 : parent_ids.size() - 1);
+
+    results.push_back(measure("get_all_tasks(all)", options.scan_iterations, [&](int)
+                              { db.get_all_tasks(true); }));
+    results.push_back(measure("get_all_tasks(active)", options.scan_iterations, [&](int)
+                              { db.get_all_tasks(false); }));
+    results.push_back(measure("for_each_task(all)", options.scan_iterations, [&](int)
+                              { db.for_each_task([](const Task &)
+                                                 { return true; }); }));
+
+    // Walk the list page by page, starting over at the end
+    optional<TaskCursor> cursor;
+    results.push_back(measure("get_tasks_page(100)", options.iterations, [&](int)
+                              {
+        TaskPage page = db.get_tasks_page(cursor, 100);
+        cursor = page.next; }));
+
+    results.push_back(measure("get_task_by_id", options.iterations, [&](int)
+                              { db.get_task_by_id(any_task(rng)); }));
+    results.push_back(measure("get_subtasks", options.iterations, [&](int)
+                              { db.get_subtasks(parent_ids.empty() ? 0 : parent_ids[any_parent(rng)]); }));
+    results.push_back(measure("add_task", options.iterations, [&](int i)
+                              { db.add_task(make_task(rng, options, task_count + i)); }));
+
+    // One sample per batch; rows/s is ops/s times the batch size
+    results.push_back(measure("add_tasks(x" + to_string(options.batch_size) + ")", options.scan_iterations, [&](int i)
+                              {
+        vector<Task> batch;
+        batch.reserve(options.batch_size);
+        for (int n = 0; n < options.batch_size; ++n)
+        {
+            batch.push_back(make_task(rng, options, task_count + options.iterations + i * options.batch_size + n));
+        }
+        db.add_tasks(batch); }));
+
+    // Update existing rows with a flipped completion state
+    results.push_back(measure("update_task", options.iterations, [&](int)
+                              {
+        auto task = db.get_task_by_id(any_task(rng));
+        if (task.has_value())
+        {
+            task->is_completed = !task->is_completed;
+            db.update_task(task.value());
+        } }));
+
+    print_results(results);
+
+    // Pooled read-only connections: aggregate throughput should grow with threads
+    if (options.readers > 0)
+    {
+        int lookups = options.iterations * 10;
+        double single = measure_parallel_reads(path, task_count, 1, lookups, options.seed);
+        double parallel = measure_parallel_reads(path, task_count, options.readers, lookups, options.seed);
+
+        cout << "pooled get_task_by_id: " << std::fixed << std::setprecision(1)
+             << single << " ops/s with 1 reader, " << parallel << " ops/s with " << options.readers
+             << " readers (x" << std::setprecision(2) << (single > 0.0 ? parallel / single : 0.0) << ")\n"
+             << std::defaultfloat << endl;
+    }
+
+    if (!options.keep)
+    {
+        remove_database(path);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+
+    try
+    {
+        if (!parse_options(argc, argv, options))
+        {
+            return 0;
+        }
+
+        for (int count : options.task_counts)
+        {
+            run_benchmark(count, options);
+        }
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error: " << e.what() << endl;
+        print_usage();
+        return 1;
+    }
+}
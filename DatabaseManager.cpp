@@ -1,508 +1,2333 @@
 #include "DatabaseManager.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
 #include <SQLiteCpp/SQLiteCpp.h>
+#include <sqlite3.h>
 
 using std::cerr;
 using std::cout;
 using std::endl;
 using std::exception;
+using std::lock_guard;
 using std::make_unique;
 using std::stringstream;
+using std::unordered_map;
+
+// Task queries; their plans are verified by teminder_tests (DatabaseTests.cpp)
+static const string TASK_SELECT = "SELECT id, description, is_completed, priority, created_at, due_date, parent_id, progress, status FROM tasks";
+static const string ALL_TASKS_SQL = TASK_SELECT + " ORDER BY priority DESC, due_date ASC";
+static const string ACTIVE_TASKS_SQL = TASK_SELECT + " WHERE is_completed = 0 ORDER BY priority DESC, due_date ASC";
+static const string TASK_BY_ID_SQL = TASK_SELECT + " WHERE id = ?";
+static const string TASKS_BY_PRIORITY_SQL = TASK_SELECT + " WHERE priority = ? ORDER BY due_date ASC";
+static const string OVERDUE_TASKS_SQL = TASK_SELECT + " WHERE due_date IS NOT NULL AND due_date < ? AND is_completed = 0 ORDER BY due_date ASC";
+static const string SUBTASKS_SQL = TASK_SELECT + " WHERE parent_id = ? ORDER BY priority DESC";
+static const string SUBTASK_COUNTS_SQL = "SELECT parent_id, "
+                                         "SUM(CASE WHEN is_completed != 0 OR status = 4 THEN 1 ELSE 0 END), COUNT(*) "
+                                         "FROM tasks WHERE parent_id IS NOT NULL GROUP BY parent_id";
+static const string TASK_LINKS_SQL = "SELECT link FROM task_links WHERE task_id = ? ORDER BY id";
+static const string TASK_TAGS_SQL = "SELECT tag_id FROM task_tags WHERE task_id = ? ORDER BY tag_id";
+static const string ALL_TAGS_SQL = "SELECT id, name FROM tags ORDER BY name";
+static const string TAG_BY_NAME_SQL = "SELECT id FROM tags WHERE name = ?";
+
+// Current time in milliseconds since the epoch, the unit of updated_at and deleted_at
+static const string NOW_MS_SQL = "CAST((julianday('now') - 2440587.5) * 86400000 AS INTEGER)";
+
+// Streaming and paged queries return each task's links in column 9, joined by LINK_SEPARATOR,
+// and its tag IDs in column 10, joined by commas
+static const char LINK_SEPARATOR = '\x1f';
+static const string TASK_TAGS_COLUMN = "(SELECT group_concat(tag_id) FROM task_tags WHERE task_id = tasks.id)";
+static const string TASK_STREAM_COLUMNS = "SELECT id, description, is_completed, priority, created_at, due_date, parent_id, progress, status, "
+                                          "(SELECT group_concat(link, char(31)) FROM task_links WHERE task_id = tasks.id), " +
+                                          TASK_TAGS_COLUMN;
+static const string TASK_STREAM_SELECT = TASK_STREAM_COLUMNS + " FROM tasks";
+static const string TASK_KEYSET_ORDER = " ORDER BY priority DESC, due_date ASC, id ASC";
+
+// for_each_task joins links instead; rows of one task arrive together, links in insertion order
+static const string TASK_LINK_JOIN_SELECT = "SELECT tasks.id, description, is_completed, priority, created_at, due_date, parent_id, progress, status, "
+                                            "task_links.link, " +
+                                            TASK_TAGS_COLUMN + " FROM tasks LEFT JOIN task_links ON task_links.task_id = tasks.id";
+static const string TASK_LINK_JOIN_ORDER = " ORDER BY priority DESC, due_date ASC, tasks.id ASC, task_links.id ASC";
+
+// Delta queries: changed tasks carry updated_at in column 11
+static const string CHANGED_TASKS_SQL = TASK_STREAM_COLUMNS + ", updated_at FROM tasks WHERE updated_at >= ? ORDER BY updated_at";
+static const string DELETED_TASKS_SQL = "SELECT task_id, deleted_at FROM task_tombstones WHERE deleted_at >= ? ORDER BY deleted_at";
+static const string CHANGE_MARK_SQL = "SELECT max(coalesce((SELECT max(updated_at) FROM tasks), 0), "
+                                      "coalesce((SELECT max(deleted_at) FROM task_tombstones), 0))";
+
+// Tombstones older than this are pruned at startup
+static const int64_t TOMBSTONE_RETENTION_MS = 30LL * 24 * 60 * 60 * 1000;
+
+// Archive tier: temp.archive_task_ids lists the tasks being archived with the root of their tree
+static const string ARCHIVE_TASK_COLUMNS = "id, description, is_completed, priority, created_at, due_date, parent_id, progress, status, updated_at";
+static const string ARCHIVE_IDS = "(SELECT id FROM temp.archive_task_ids WHERE stale = 0)";
+static const string ARCHIVE_STALE_IDS = "(SELECT id FROM temp.archive_task_ids WHERE stale = 1)";
+static const string ARCHIVE_CANDIDATES_SQL = "WITH RECURSIVE tree(root, id) AS ("
+                                             "SELECT id, id FROM main.tasks WHERE parent_id IS NULL AND is_completed = 1 AND updated_at < ?1 "
+                                             "UNION SELECT tree.root, tasks.id FROM main.tasks JOIN tree ON tasks.parent_id = tree.id) "
+                                             "INSERT OR IGNORE INTO temp.archive_task_ids (id, root, stale) SELECT id, root, 0 FROM tree";
+static const string ARCHIVE_OPEN_TREES_SQL = "DELETE FROM temp.archive_task_ids WHERE root IN ("
+                                             "SELECT ids.root FROM temp.archive_task_ids AS ids CROSS JOIN main.tasks ON tasks.id = ids.id "
+                                             "WHERE tasks.is_completed = 0 OR tasks.updated_at >= ?1)";
+static const string ARCHIVE_STALE_TREES_SQL = "UPDATE temp.archive_task_ids SET stale = 1 WHERE root IN ("
+                                              "SELECT ids.root FROM temp.archive_task_ids AS ids "
+                                              "LEFT JOIN archive.tasks AS copy ON copy.id = ids.id "
+                                              "LEFT JOIN main.tasks AS hot ON hot.id = ids.id "
+                                              "WHERE copy.id IS NULL OR hot.updated_at IS NOT copy.updated_at)";
+// A child of a tree task that is not part of the tree was added (or moved there) since the copy
+static const string ARCHIVE_GROWN_TREES_SQL = "UPDATE temp.archive_task_ids SET stale = 1 WHERE root IN ("
+                                              "SELECT ids.root FROM temp.archive_task_ids AS ids "
+                                              "CROSS JOIN main.tasks AS child ON child.parent_id = ids.id "
+                                              "WHERE child.id NOT IN (SELECT id FROM temp.archive_task_ids))";
+static const string ARCHIVE_SELECT = "SELECT a.id, a.description, a.is_completed, a.priority, a.created_at, a.due_date, a.parent_id, a.progress, a.status, "
+                                     "(SELECT group_concat(link, char(31)) FROM archive.task_links WHERE task_id = a.id), "
+                                     "(SELECT group_concat(tag_id) FROM archive.task_tags WHERE task_id = a.id AND tag_id IN (SELECT id FROM main.tags))";
+// A crash between the two archive transactions can leave a task in both places; the tasks table wins
+static const string ARCHIVE_NOT_HOT = "NOT EXISTS (SELECT 1 FROM main.tasks WHERE id = a.id)";
+
+/**
+ * @brief Key ranges that together make up "after the cursor" in TASK_KEYSET_ORDER
+ * Scanned in this order, each one is a single index seek, so a page costs the
+ * same wherever the cursor is. (due_date NULLs sort first.)
+ */
+enum class KeysetRange
+{
+    First,          // No cursor: from the start
+    SameDue,        // priority = P, due_date IS D, id > I
+    LaterDue,       // priority = P, due_date > D
+    AnyDue,         // priority = P, due_date IS NOT NULL (cursor had no due date)
+    LowerPriority,  // priority < P
+};
+
+static string task_page_sql(bool include_completed, KeysetRange range)
+{
+    string condition;
+    switch (range)
+    {
+    case KeysetRange::First:
+        break;
+    case KeysetRange::SameDue:
+        condition = "priority = :priority AND due_date IS :due_date AND id > :id";
+        break;
+    case KeysetRange::LaterDue:
+        condition = "priority = :priority AND due_date > :due_date";
+        break;
+    case KeysetRange::AnyDue:
+        condition = "priority = :priority AND due_date IS NOT NULL";
+        break;
+    case KeysetRange::LowerPriority:
+        condition = "priority < :priority";
+        break;
+    }
+
+    if (!include_completed)
+    {
+        condition = condition.empty() ? "is_completed = 0" : "is_completed = 0 AND " + condition;
+    }
+
+    string sql = TASK_STREAM_SELECT;
+    if (!condition.empty())
+    {
+        sql += " WHERE " + condition;
+    }
+    return sql + TASK_KEYSET_ORDER + " LIMIT :limit";
+}
 
-DatabaseManager::DatabaseManager(const string &db_path)
-    : db_path(db_path)
+DatabaseManager::DatabaseManager(const string &db_path, const SqliteProfile &profile, bool read_only)
+    : db_path(db_path), read_only(read_only), archive_attached(false), archive_full_text_search(false),
+      transaction_depth(0), next_subscription(1),
+      statement_cache_hits(0), statement_cache_misses(0)
 {
     try
     {
         db = make_unique<SQLite::Database>(
             db_path,
-            SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
-        cout << "Database opened successfully: " << db_path << endl;
+            read_only ? SQLite::OPEN_READONLY : SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+
+        // Read-only connections are opened on demand by worker threads, so they stay quiet
+        if (!read_only)
+        {
+            cout << "Database opened successfully: " << db_path << endl;
+        }
     }
     catch (const exception &e)
     {
         cerr << "Error opening database: " << e.what() << endl;
         throw;
     }
+
+    apply_profile(profile);
+
+    // Capture task changes for the change feed; read-only connections never make any
+    if (!read_only)
+    {
+        sqlite3_update_hook(db->getHandle(), &DatabaseManager::on_row_change, this);
+        sqlite3_commit_hook(db->getHandle(), &DatabaseManager::on_commit, this);
+        sqlite3_rollback_hook(db->getHandle(), &DatabaseManager::on_rollback, this);
+    }
 }
 
-void DatabaseManager::initilize_database()
+DatabaseManager::~DatabaseManager()
+{
+    if (db && !read_only)
+    {
+        sqlite3_update_hook(db->getHandle(), nullptr, nullptr);
+        sqlite3_commit_hook(db->getHandle(), nullptr, nullptr);
+        sqlite3_rollback_hook(db->getHandle(), nullptr, nullptr);
+    }
+}
+
+int DatabaseManager::subscribe_changes(TaskChangeListener listener)
+{
+    lock_guard<std::mutex> lock(listener_mutex);
+    int subscription = next_subscription++;
+    change_listeners.emplace_back(subscription, std::move(listener));
+    return subscription;
+}
+
+void DatabaseManager::unsubscribe_changes(int subscription)
+{
+    lock_guard<std::mutex> lock(listener_mutex);
+    change_listeners.erase(std::remove_if(change_listeners.begin(), change_listeners.end(),
+                                          [&](const pair<int, TaskChangeListener> &entry)
+                                          { return entry.first == subscription; }),
+                           change_listeners.end());
+}
+
+void DatabaseManager::on_row_change(void *manager, int operation, const char *database, const char *table, long long row_id)
+{
+    // Triggers and temp tables also fire the hook; only task rows are published
+    if (std::strcmp(database, "main") != 0 || std::strcmp(table, "tasks") != 0)
+    {
+        return;
+    }
+
+    TaskChangeType type = operation == SQLITE_INSERT   ? TaskChangeType::Inserted
+                          : operation == SQLITE_DELETE ? TaskChangeType::Deleted
+                                                       : TaskChangeType::Updated;
+    static_cast<DatabaseManager *>(manager)->note_task_change(type, static_cast<int>(row_id));
+}
+
+int DatabaseManager::on_commit(void *manager)
+{
+    auto *self = static_cast<DatabaseManager *>(manager);
+    self->committed_changes.insert(self->committed_changes.end(),
+                                   self->pending_changes.begin(), self->pending_changes.end());
+    self->pending_changes.clear();
+    return 0;
+}
+
+void DatabaseManager::on_rollback(void *manager)
+{
+    static_cast<DatabaseManager *>(manager)->pending_changes.clear();
+}
+
+void DatabaseManager::note_task_change(TaskChangeType type, int task_id)
+{
+    pending_changes.push_back(TaskChange{type, task_id});
+}
+
+void DatabaseManager::publish_changes()
+{
+    if (committed_changes.empty())
+    {
+        return;
+    }
+
+    // One entry per task, in order of first change
+    vector<TaskChange> changes;
+    unordered_map<int, size_t> positions;
+    for (const auto &change : committed_changes)
+    {
+        auto [it, inserted] = positions.emplace(change.task_id, changes.size());
+        if (inserted)
+        {
+            changes.push_back(change);
+            continue;
+        }
+
+        TaskChange &merged = changes[it->second];
+        if (change.type == TaskChangeType::Deleted)
+        {
+            merged.type = TaskChangeType::Deleted;
+        }
+        else if (merged.type == TaskChangeType::Deleted)
+        {
+            merged.type = TaskChangeType::Updated; // ID reused by a new row
+        }
+        // Inserted followed by updates is still an insert
+    }
+    committed_changes.clear();
+
+    vector<TaskChangeListener> listeners;
+    {
+        lock_guard<std::mutex> lock(listener_mutex);
+        for (const auto &entry : change_listeners)
+        {
+            listeners.push_back(entry.second);
+        }
+    }
+
+    for (const auto &listener : listeners)
+    {
+        try
+        {
+            listener(changes);
+        }
+        catch (const exception &e)
+        {
+            cerr << "Error in change listener: " << e.what() << endl;
+        }
+    }
+}
+
+void DatabaseManager::apply_profile(const SqliteProfile &profile)
 {
+    // Keyword pragmas are spliced into SQL, so only known values are accepted
+    auto keyword = [](const string &value, const vector<string> &allowed) -> string
+    {
+        string upper = value;
+        std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::toupper(c)); });
+        return std::find(allowed.begin(), allowed.end(), upper) != allowed.end() ? upper : "";
+    };
+
+    auto apply = [&](const string &name, const string &value)
+    {
+        if (value.empty())
+        {
+            cerr << "Warning: Ignoring invalid database setting '" << name << "'" << endl;
+            return;
+        }
+
+        try
+        {
+            // journal_mode returns a row, so step through the result instead of exec()
+            SQLite::Statement pragma(*db, "PRAGMA " + name + " = " + value);
+            while (pragma.executeStep())
+            {
+            }
+        }
+        catch (const exception &e)
+        {
+            cerr << "Warning: Could not set " << name << ": " << e.what() << endl;
+        }
+    };
+
+    db->setBusyTimeout(std::max(0, profile.busy_timeout_ms));
+    if (read_only)
+    {
+        // The journal mode belongs to the file and is set by the read-write connection
+        apply("mmap_size", std::to_string(std::max(0LL, profile.mmap_size)));
+        apply("cache_size", std::to_string(profile.cache_size));
+        apply("temp_store", keyword(profile.temp_store, {"DEFAULT", "FILE", "MEMORY"}));
+        return;
+    }
+
+    apply("journal_mode", keyword(profile.journal_mode, {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"}));
+    apply("synchronous", keyword(profile.synchronous, {"OFF", "NORMAL", "FULL", "EXTRA"}));
+    apply("mmap_size", std::to_string(std::max(0LL, profile.mmap_size)));
+    apply("cache_size", std::to_string(profile.cache_size));
+    apply("temp_store", keyword(profile.temp_store, {"DEFAULT", "FILE", "MEMORY"}));
+
+    // Report what SQLite actually uses; e.g. WAL is refused for in-memory databases
     try
     {
-        // Create tasks table
-        db->exec(
-            "CREATE TABLE IF NOT EXISTS tasks ("
-            "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-            "description TEXT NOT NULL, "
-            "is_completed INTEGER NOT NULL DEFAULT 0, "
-            "priority INTEGER NOT NULL DEFAULT 0, "
-            "created_at INTEGER NOT NULL, "
-            "due_date INTEGER, "
-            "parent_id INTEGER, "
-            "progress INTEGER NOT NULL DEFAULT 0, "
-            "FOREIGN KEY (parent_id) REFERENCES tasks(id) ON DELETE CASCADE"
-            ");");
+        cout << "Database settings: journal_mode=" << pragma_value("journal_mode")
+             << " synchronous=" << pragma_value("synchronous")
+             << " mmap_size=" << pragma_value("mmap_size")
+             << " cache_size=" << pragma_value("cache_size")
+             << " temp_store=" << pragma_value("temp_store")
+             << " busy_timeout=" << pragma_value("busy_timeout") << endl;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Warning: Could not read database settings: " << e.what() << endl;
+    }
+}
 
-        // Create task_links table for storing multiple links per task
-        db->exec(
-            "CREATE TABLE IF NOT EXISTS task_links ("
-            "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-            "task_id INTEGER NOT NULL, "
-            "link TEXT NOT NULL, "
-            "FOREIGN KEY (task_id) REFERENCES tasks(id) ON DELETE CASCADE"
-            ");");
+string DatabaseManager::pragma_value(const string &name)
+{
+    SQLite::Statement pragma(*db, "PRAGMA " + name);
+    return pragma.executeStep() ? pragma.getColumn(0).getText() : "";
+}
 
-        // Create tags table
-        db->exec(
-            "CREATE TABLE IF NOT EXISTS tags ("
-            "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-            "name TEXT UNIQUE NOT NULL"
-            ");");
+/**
+ * @brief One step of the schema history
+ * Applied once, in its own transaction, when the stored user_version is lower.
+ * Append new steps at the end; never edit a step that has shipped.
+ */
+struct SchemaMigration
+{
+    int version;
+    const char *description;
+    void (*apply)(SQLite::Database &db);
+};
+
+/**
+ * @brief Base schema
+ * Databases created before versioning already have these tables, possibly
+ * without the progress/status columns, so those are added when missing.
+ */
+static void migrate_base_schema(SQLite::Database &db)
+{
+    // Create tasks table
+    db.exec(
+        "CREATE TABLE IF NOT EXISTS tasks ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "description TEXT NOT NULL, "
+        "is_completed INTEGER NOT NULL DEFAULT 0, "
+        "priority INTEGER NOT NULL DEFAULT 0, "
+        "created_at INTEGER NOT NULL, "
+        "due_date INTEGER, "
+        "parent_id INTEGER, "
+        "progress INTEGER NOT NULL DEFAULT 0, "
+        "status INTEGER NOT NULL DEFAULT 0, "
+        "FOREIGN KEY (parent_id) REFERENCES tasks(id) ON DELETE CASCADE"
+        ");");
+
+    // Create task_links table for storing multiple links per task
+    db.exec(
+        "CREATE TABLE IF NOT EXISTS task_links ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "task_id INTEGER NOT NULL, "
+        "link TEXT NOT NULL, "
+        "FOREIGN KEY (task_id) REFERENCES tasks(id) ON DELETE CASCADE"
+        ");");
+
+    // Create tags table
+    db.exec(
+        "CREATE TABLE IF NOT EXISTS tags ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "name TEXT UNIQUE NOT NULL"
+        ");");
+
+    // Create task_tags junction table
+    db.exec(
+        "CREATE TABLE IF NOT EXISTS task_tags ("
+        "task_id INTEGER NOT NULL, "
+        "tag_id INTEGER NOT NULL, "
+        "PRIMARY KEY (task_id, tag_id), "
+        "FOREIGN KEY (task_id) REFERENCES tasks(id) ON DELETE CASCADE, "
+        "FOREIGN KEY (tag_id) REFERENCES tags(id) ON DELETE CASCADE"
+        ");");
+
+    // Create indices for better performance
+    db.exec("CREATE INDEX IF NOT EXISTS idx_tasks_priority ON tasks(priority);");
+    db.exec("CREATE INDEX IF NOT EXISTS idx_tasks_due_date ON tasks(due_date);");
+    db.exec("CREATE INDEX IF NOT EXISTS idx_tasks_parent_id ON tasks(parent_id);");
+    db.exec("CREATE INDEX IF NOT EXISTS idx_task_links_task_id ON task_links(task_id);");
+
+    // Columns added after the first release
+    bool has_progress = false;
+    bool has_status = false;
+    SQLite::Statement columns(db, "PRAGMA table_info(tasks)");
+    while (columns.executeStep())
+    {
+        string name = columns.getColumn(1).getText();
+        has_progress = has_progress || name == "progress";
+        has_status = has_status || name == "status";
+    }
+    columns.reset();
+
+    if (!has_progress)
+    {
+        db.exec("ALTER TABLE tasks ADD COLUMN progress INTEGER NOT NULL DEFAULT 0;");
+    }
+    if (!has_status)
+    {
+        db.exec("ALTER TABLE tasks ADD COLUMN status INTEGER NOT NULL DEFAULT 0;");
+    }
+}
+
+/**
+ * @brief Indexes shaped after the task queries
+ * Replaces the single-column indexes, which left ORDER BY priority, due_date
+ * to a temporary B-tree sort.
+ */
+static void migrate_query_indexes(SQLite::Database &db)
+{
+    // Full list and per-priority list in display order
+    db.exec("CREATE INDEX IF NOT EXISTS idx_tasks_priority_due ON tasks(priority DESC, due_date ASC);");
+
+    // Active-only list; completed rows are left out of the index entirely
+    db.exec("CREATE INDEX IF NOT EXISTS idx_tasks_active ON tasks(priority DESC, due_date ASC) WHERE is_completed = 0;");
+
+    // Overdue scan: open tasks with a due date, ordered by due date
+    db.exec("CREATE INDEX IF NOT EXISTS idx_tasks_overdue ON tasks(due_date) WHERE is_completed = 0 AND due_date IS NOT NULL;");
+
+    // Subtasks of a parent in priority order; also covers the subtask count rollup
+    db.exec("CREATE INDEX IF NOT EXISTS idx_tasks_parent ON tasks(parent_id, priority DESC, is_completed, status) WHERE parent_id IS NOT NULL;");
+
+    // Prefixes of the indexes above
+    db.exec("DROP INDEX IF EXISTS idx_tasks_priority;");
+    db.exec("DROP INDEX IF EXISTS idx_tasks_due_date;");
+    db.exec("DROP INDEX IF EXISTS idx_tasks_parent_id;");
+}
+
+/**
+ * @brief Create the full-text index over task descriptions and links and fill it
+ * tasks_fts shares rowids with tasks and is kept in sync by triggers.
+ * @return false if this SQLite build has no FTS5; nothing is created then
+ */
+static bool create_full_text_search(SQLite::Database &db)
+{
+    try
+    {
+        db.exec("CREATE VIRTUAL TABLE IF NOT EXISTS tasks_fts USING fts5(description, links, prefix = '2 3');");
+    }
+    catch (const exception &e)
+    {
+        cerr << "Warning: Full-text search unavailable (" << e.what() << "), using LIKE search" << endl;
+        return false;
+    }
+
+    db.exec("CREATE TRIGGER IF NOT EXISTS tasks_fts_insert AFTER INSERT ON tasks BEGIN "
+            "INSERT INTO tasks_fts (rowid, description, links) VALUES (new.id, new.description, ''); "
+            "END;");
+    db.exec("CREATE TRIGGER IF NOT EXISTS tasks_fts_update AFTER UPDATE OF description ON tasks BEGIN "
+            "UPDATE tasks_fts SET description = new.description WHERE rowid = new.id; "
+            "END;");
+    db.exec("CREATE TRIGGER IF NOT EXISTS tasks_fts_delete AFTER DELETE ON tasks BEGIN "
+            "DELETE FROM tasks_fts WHERE rowid = old.id; "
+            "END;");
+
+    // Links of a task are indexed as one space-separated column
+    db.exec("CREATE TRIGGER IF NOT EXISTS tasks_fts_link_insert AFTER INSERT ON task_links BEGIN "
+            "UPDATE tasks_fts SET links = (SELECT group_concat(link, ' ') FROM task_links WHERE task_id = new.task_id) "
+            "WHERE rowid = new.task_id; "
+            "END;");
+    db.exec("CREATE TRIGGER IF NOT EXISTS tasks_fts_link_delete AFTER DELETE ON task_links BEGIN "
+            "UPDATE tasks_fts SET links = coalesce((SELECT group_concat(link, ' ') FROM task_links WHERE task_id = old.task_id), '') "
+            "WHERE rowid = old.task_id; "
+            "END;");
+
+    // Index the existing tasks
+    db.exec("DELETE FROM tasks_fts;");
+    db.exec("INSERT INTO tasks_fts (rowid, description, links) "
+            "SELECT id, description, coalesce((SELECT group_concat(link, ' ') FROM task_links WHERE task_id = tasks.id), '') "
+            "FROM tasks;");
+    return true;
+}
+
+/**
+ * @brief Full-text index over task descriptions and links
+ * SQLite builds without FTS5 skip the index and search falls back to LIKE;
+ * DatabaseManager::ensure_full_text_search() creates it once FTS5 is available.
+ */
+static void migrate_full_text_search(SQLite::Database &db)
+{
+    create_full_text_search(db);
+}
 
-        // Create task_tags junction table
-        db->exec(
-            "CREATE TABLE IF NOT EXISTS task_tags ("
-            "task_id INTEGER NOT NULL, "
-            "tag_id INTEGER NOT NULL, "
-            "PRIMARY KEY (task_id, tag_id), "
-            "FOREIGN KEY (task_id) REFERENCES tasks(id) ON DELETE CASCADE, "
-            "FOREIGN KEY (tag_id) REFERENCES tags(id) ON DELETE CASCADE"
+/**
+ * @brief Reverse lookup for tag assignments
+ * The primary key only serves task -> tags; this serves tag -> tasks and tag deletion.
+ */
+static void migrate_tag_index(SQLite::Database &db)
+{
+    db.exec("CREATE INDEX IF NOT EXISTS idx_task_tags_tag_id ON task_tags(tag_id);");
+}
+
+/**
+ * @brief Change tracking for delta reads
+ * updated_at is the time of a task's last change in milliseconds. This class
+ * sets it on every write; the triggers cover other writers (scripts, older
+ * builds) and changes to a task's links and tags. Deleted tasks leave a
+ * tombstone so readers can tell deletions from tasks they never saw.
+ */
+static void migrate_change_tracking(SQLite::Database &db)
+{
+    db.exec("ALTER TABLE tasks ADD COLUMN updated_at INTEGER NOT NULL DEFAULT 0;");
+    // When a task last changed is unknown: date existing rows from the upgrade,
+    // so completed tasks are not archived right away as if long untouched
+    db.exec("UPDATE tasks SET updated_at = " + NOW_MS_SQL + ";");
+    db.exec("CREATE INDEX IF NOT EXISTS idx_tasks_updated_at ON tasks(updated_at);");
+
+    db.exec("CREATE TABLE IF NOT EXISTS task_tombstones ("
+            "task_id INTEGER PRIMARY KEY, "
+            "deleted_at INTEGER NOT NULL"
             ");");
+    db.exec("CREATE INDEX IF NOT EXISTS idx_task_tombstones_deleted_at ON task_tombstones(deleted_at);");
+
+    // Only writes that left updated_at alone need the extra update
+    db.exec("CREATE TRIGGER IF NOT EXISTS tasks_touch_insert AFTER INSERT ON tasks WHEN new.updated_at = 0 BEGIN "
+            "UPDATE tasks SET updated_at = " + NOW_MS_SQL + " WHERE id = new.id; "
+            "END;");
+    db.exec("CREATE TRIGGER IF NOT EXISTS tasks_touch_update AFTER UPDATE ON tasks WHEN new.updated_at = old.updated_at BEGIN "
+            "UPDATE tasks SET updated_at = " + NOW_MS_SQL + " WHERE id = new.id; "
+            "END;");
+    db.exec("CREATE TRIGGER IF NOT EXISTS tasks_tombstone AFTER DELETE ON tasks BEGIN "
+            "INSERT OR REPLACE INTO task_tombstones (task_id, deleted_at) VALUES (old.id, " + NOW_MS_SQL + "); "
+            "END;");
+
+    // Links and tags belong to the task; a task already touched in this millisecond is left alone
+    const string touch_task = "UPDATE tasks SET updated_at = " + NOW_MS_SQL + " WHERE id = %s.task_id AND updated_at < " + NOW_MS_SQL + "; ";
+    for (const string table : {"task_links", "task_tags"})
+    {
+        for (const string event : {"INSERT", "DELETE"})
+        {
+            string row = event == "INSERT" ? "new" : "old";
+            string body = touch_task;
+            body.replace(body.find("%s"), 2, row);
+
+            string name = table + "_touch_" + (event == "INSERT" ? "insert" : "delete");
+            db.exec("CREATE TRIGGER IF NOT EXISTS " + name + " AFTER " + event + " ON " + table + " BEGIN " + body + "END;");
+        }
+    }
+}
+
+static const vector<SchemaMigration> &schema_migrations()
+{
+    static const vector<SchemaMigration> migrations = {
+        {1, "base schema", migrate_base_schema},
+        {2, "query indexes", migrate_query_indexes},
+        {3, "full-text search", migrate_full_text_search},
+        {4, "tag index", migrate_tag_index},
+        {5, "change tracking", migrate_change_tracking},
+    };
+    return migrations;
+}
+
+void DatabaseManager::initilize_database()
+{
+    try
+    {
+        const auto &migrations = schema_migrations();
+        int latest = migrations.empty() ? 0 : migrations.back().version;
+
+        // Warm start: one pragma read and nothing else
+        int version = get_schema_version();
+        if (version >= latest)
+        {
+            cout << "Database initialized successfully." << endl;
+            return;
+        }
+
+        for (const auto &migration : migrations)
+        {
+            // IMMEDIATE takes the write lock up front; re-check in case another process migrated first
+            SQLite::Transaction transaction(*db, SQLite::TransactionBehavior::IMMEDIATE);
+            version = get_schema_version();
+            if (migration.version <= version)
+            {
+                continue;
+            }
+
+            cout << "Migrating database to version " << migration.version << ": " << migration.description << "..." << endl;
+            migration.apply(*db);
+            db->exec("PRAGMA user_version = " + std::to_string(migration.version));
+            transaction.commit();
+        }
+
+        // Backfills are not changes anyone needs to hear about
+        committed_changes.clear();
+
+        cout << "Migration complete." << endl;
+        cout << "Database initialized successfully." << endl;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error initializing database: " << e.what() << endl;
+        throw;
+    }
+}
+
+int DatabaseManager::get_schema_version()
+{
+    SQLite::Statement query(*db, "PRAGMA user_version");
+    return query.executeStep() ? query.getColumn(0).getInt() : 0;
+}
+
+long long DatabaseManager::get_data_version()
+{
+    try
+    {
+        SQLite::Statement query(*db, "PRAGMA data_version");
+        return query.executeStep() ? query.getColumn(0).getInt64() : -1;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error reading data version: " << e.what() << endl;
+        return -1;
+    }
+}
+
+bool DatabaseManager::run_in_transaction(const function<bool()> &work)
+{
+    try
+    {
+        TransactionScope transaction(*this);
+        if (!work())
+        {
+            return false;
+        }
+        transaction.commit();
+        return true;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error in transaction: " << e.what() << endl;
+        return false;
+    }
+}
+
+bool DatabaseManager::run_in_snapshot(const function<void()> &work)
+{
+    if (transaction_depth > 0)
+    {
+        // Already inside a transaction, which reads from one snapshot anyway
+        try
+        {
+            work();
+            return true;
+        }
+        catch (const exception &e)
+        {
+            cerr << "Error in read snapshot: " << e.what() << endl;
+            return false;
+        }
+    }
+
+    try
+    {
+        // A deferred transaction pins the snapshot at its first read
+        db->exec("BEGIN");
+        transaction_depth++;
+        work();
+        db->exec("COMMIT");
+        transaction_depth--;
+        return true;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error in read snapshot: " << e.what() << endl;
+        if (transaction_depth > 0)
+        {
+            transaction_depth--;
+            try
+            {
+                db->exec("ROLLBACK");
+            }
+            catch (const exception &)
+            {
+                // No transaction left to roll back
+            }
+        }
+        return false;
+    }
+}
+
+DatabaseManager::TransactionScope::TransactionScope(DatabaseManager &manager)
+    : manager(manager), nested(manager.transaction_depth > 0), change_mark(manager.pending_changes.size())
+{
+    // IMMEDIATE takes the write lock up front, so the busy timeout applies here
+    // rather than failing when a deferred transaction tries to upgrade
+    manager.db->exec(nested ? "SAVEPOINT nested_write" : "BEGIN IMMEDIATE");
+    manager.transaction_depth++;
+}
+
+void DatabaseManager::TransactionScope::commit()
+{
+    manager.db->exec(nested ? "RELEASE nested_write" : "COMMIT");
+    committed = true;
+}
+
+DatabaseManager::TransactionScope::~TransactionScope()
+{
+    manager.transaction_depth--;
+    if (committed)
+    {
+        // Listeners run outside the transaction
+        if (!nested)
+        {
+            manager.publish_changes();
+        }
+        return;
+    }
+
+    try
+    {
+        // A rolled back savepoint stays open until released
+        manager.db->exec(nested ? "ROLLBACK TO nested_write; RELEASE nested_write" : "ROLLBACK");
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error rolling back transaction: " << e.what() << endl;
+    }
+
+    // The rollback hook only covers whole transactions, not savepoints
+    if (manager.pending_changes.size() > change_mark)
+    {
+        manager.pending_changes.resize(change_mark);
+    }
+    if (!nested)
+    {
+        manager.committed_changes.clear(); // A failed COMMIT runs the commit hook first
+    }
+}
+
+int DatabaseManager::add_task(const Task &task)
+{
+    try
+    {
+        // Task row and links commit together with a single sync
+        TransactionScope transaction(*this);
+        int task_id = insert_task_row(task);
+        transaction.commit();
 
-        // Create indices for better performance
-        db->exec("CREATE INDEX IF NOT EXISTS idx_tasks_priority ON tasks(priority);");
-        db->exec("CREATE INDEX IF NOT EXISTS idx_tasks_due_date ON tasks(due_date);");
-        db->exec("CREATE INDEX IF NOT EXISTS idx_tasks_parent_id ON tasks(parent_id);");
-        db->exec("CREATE INDEX IF NOT EXISTS idx_task_links_task_id ON task_links(task_id);");
+        return task_id;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error adding task: " << e.what() << endl;
+        return -1;
+    }
+}
+
+vector<int> DatabaseManager::add_tasks(const vector<Task> &tasks)
+{
+    vector<int> task_ids;
+    task_ids.reserve(tasks.size());
+
+    try
+    {
+        TransactionScope transaction(*this);
+        for (const auto &task : tasks)
+        {
+            task_ids.push_back(insert_task_row(task));
+        }
+        transaction.commit();
+
+        return task_ids;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error adding tasks: " << e.what() << endl;
+        return {};
+    }
+}
+
+int DatabaseManager::insert_task_row(const Task &task)
+{
+    int task_id;
+    {
+        auto query = cached_statement("INSERT INTO tasks (description, is_completed, priority, created_at, due_date, parent_id, progress, status, updated_at) "
+                                      "VALUES (?, ?, ?, ?, ?, ?, ?, ?, " + NOW_MS_SQL + ")");
+
+        query->bind(1, task.description);
+        query->bind(2, task.is_completed ? 1 : 0);
+        query->bind(3, task.priority);
+        query->bind(4, static_cast<int64_t>(task.created_at));
+
+        if (task.due_date.has_value())
+        {
+            query->bind(5, static_cast<int64_t>(task.due_date.value()));
+        }
+        else
+        {
+            query->bind(5); // NULL
+        }
+
+        if (task.parent_id.has_value())
+        {
+            query->bind(6, task.parent_id.value());
+        }
+        else
+        {
+            query->bind(6); // NULL
+        }
+
+        query->bind(7, task.progress);
+        query->bind(8, task.status);
+
+        query->exec();
+
+        task_id = static_cast<int>(db->getLastInsertRowid());
+    }
+
+    // Add links; errors propagate so the caller's transaction rolls back
+    if (!task.links.empty())
+    {
+        auto link_query = cached_statement("INSERT INTO task_links (task_id, link) VALUES (?, ?)");
+        for (const auto &link : task.links)
+        {
+            link_query->bind(1, task_id);
+            link_query->bind(2, link);
+            link_query->exec();
+            link_query->reset();
+        }
+    }
+
+    if (!task.tags.empty())
+    {
+        insert_task_tags(task_id, task.tags);
+    }
+
+    return task_id;
+}
+
+void DatabaseManager::insert_task_tags(int task_id, const vector<int> &tag_ids)
+{
+    auto tag_query = cached_statement("INSERT OR IGNORE INTO task_tags (task_id, tag_id) VALUES (?, ?)");
+    for (int tag_id : tag_ids)
+    {
+        tag_query->bind(1, task_id);
+        tag_query->bind(2, tag_id);
+        tag_query->exec();
+        tag_query->reset();
+    }
+}
+
+vector<Task> DatabaseManager::get_all_tasks(bool include_completed)
+{
+    vector<Task> tasks;
+
+    // Rows, links and tags must see the same commits
+    bool ok = run_in_snapshot([&]()
+                              {
+        auto query = cached_statement(include_completed ? ALL_TASKS_SQL : ACTIVE_TASKS_SQL);
+
+        while (query->executeStep())
+        {
+            tasks.push_back(read_task_row(*query));
+        }
+
+        // Load links and tags for all returned tasks in one pass each
+        load_links(tasks, include_completed ? "" : "tasks.is_completed = 0");
+        load_tags(tasks, include_completed ? "" : "tasks.is_completed = 0"); });
+    if (!ok)
+    {
+        cerr << "Error getting all tasks" << endl;
+        tasks.clear();
+    }
+
+    return tasks;
+}
+
+optional<Task> DatabaseManager::get_task_by_id(int task_id)
+{
+    optional<Task> task;
+
+    bool ok = run_in_snapshot([&]()
+                              {
+        auto query = cached_statement(TASK_BY_ID_SQL);
+
+        query->bind(1, task_id);
+
+        if (query->executeStep())
+        {
+            task = read_task_row(*query);
+
+            // Load links and tags
+            task->links = get_task_links(task->id);
+            task->tags = get_task_tags(task->id);
+        } });
+    if (!ok)
+    {
+        cerr << "Error getting task by ID" << endl;
+        return std::nullopt;
+    }
+
+    return task;
+}
+
+bool DatabaseManager::update_task(const Task &task)
+{
+    try
+    {
+        // Row and tag assignments change together
+        TransactionScope transaction(*this);
+
+        auto query = cached_statement("UPDATE tasks SET description = ?, is_completed = ?, priority = ?, "
+                                      "due_date = ?, parent_id = ?, progress = ?, status = ?, updated_at = " + NOW_MS_SQL + " WHERE id = ?");
+
+        query->bind(1, task.description);
+        query->bind(2, task.is_completed ? 1 : 0);
+        query->bind(3, task.priority);
+
+        if (task.due_date.has_value())
+        {
+            query->bind(4, static_cast<int64_t>(task.due_date.value()));
+        }
+        else
+        {
+            query->bind(4); // NULL
+        }
+
+        if (task.parent_id.has_value())
+        {
+            query->bind(5, task.parent_id.value());
+        }
+        else
+        {
+            query->bind(5); // NULL
+        }
+
+        query->bind(6, task.progress);
+        query->bind(7, task.status);
+        query->bind(8, task.id);
+
+        query->exec();
+
+        replace_task_tags(task.id, task.tags);
+        transaction.commit();
+
+        return true;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error updating task: " << e.what() << endl;
+        return false;
+    }
+}
+
+bool DatabaseManager::delete_task(int task_id)
+{
+    // Subtasks are only reachable through their parent, so they go with it
+    return delete_tasks({task_id}) >= 0;
+}
+
+int DatabaseManager::update_tasks(const vector<int> &task_ids, const TaskPatch &patch, bool include_subtasks)
+{
+    try
+    {
+        TransactionScope transaction(*this);
+        select_bulk_ids(task_ids, nullptr, include_subtasks);
+        int updated = update_bulk_ids(patch);
+        transaction.commit();
+        return updated;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error updating tasks: " << e.what() << endl;
+        return -1;
+    }
+}
+
+int DatabaseManager::update_tasks_where(const TaskFilter &filter, const TaskPatch &patch, bool include_subtasks)
+{
+    try
+    {
+        TransactionScope transaction(*this);
+        select_bulk_ids({}, &filter, include_subtasks);
+        int updated = update_bulk_ids(patch);
+        transaction.commit();
+        return updated;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error updating tasks: " << e.what() << endl;
+        return -1;
+    }
+}
+
+int DatabaseManager::delete_tasks(const vector<int> &task_ids, vector<int> *deleted_ids)
+{
+    try
+    {
+        TransactionScope transaction(*this);
+        select_bulk_ids(task_ids, nullptr, true);
+        int deleted = delete_bulk_ids(deleted_ids);
+        transaction.commit();
+        return deleted;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error deleting tasks: " << e.what() << endl;
+        if (deleted_ids)
+        {
+            deleted_ids->clear();
+        }
+        return -1;
+    }
+}
+
+int DatabaseManager::delete_tasks_where(const TaskFilter &filter, vector<int> *deleted_ids)
+{
+    try
+    {
+        TransactionScope transaction(*this);
+        select_bulk_ids({}, &filter, true);
+        int deleted = delete_bulk_ids(deleted_ids);
+        transaction.commit();
+        return deleted;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error deleting tasks: " << e.what() << endl;
+        if (deleted_ids)
+        {
+            deleted_ids->clear();
+        }
+        return -1;
+    }
+}
+
+void DatabaseManager::select_bulk_ids(const vector<int> &task_ids, const TaskFilter *filter, bool include_subtasks)
+{
+    db->exec("CREATE TEMP TABLE IF NOT EXISTS bulk_task_ids (id INTEGER PRIMARY KEY)");
+    db->exec("DELETE FROM temp.bulk_task_ids");
+
+    if (filter)
+    {
+        vector<int64_t> params;
+        string condition = filter_condition(*filter, params);
+        string sql = "INSERT INTO temp.bulk_task_ids (id) SELECT id FROM tasks";
+        if (!condition.empty())
+        {
+            sql += " WHERE " + condition;
+        }
+
+        auto query = cached_statement(sql);
+        for (size_t i = 0; i < params.size(); ++i)
+        {
+            query->bind(static_cast<int>(i + 1), params[i]);
+        }
+        query->exec();
+    }
+    else
+    {
+        auto query = cached_statement("INSERT OR IGNORE INTO temp.bulk_task_ids (id) VALUES (?)");
+        for (int task_id : task_ids)
+        {
+            query->bind(1, task_id);
+            query->exec();
+            query->reset();
+        }
+    }
+
+    if (include_subtasks)
+    {
+        auto query = cached_statement("WITH RECURSIVE subtree(id) AS ("
+                                      "SELECT id FROM temp.bulk_task_ids "
+                                      "UNION SELECT tasks.id FROM tasks JOIN subtree ON tasks.parent_id = subtree.id) "
+                                      "INSERT OR IGNORE INTO temp.bulk_task_ids (id) SELECT id FROM subtree");
+        query->exec();
+    }
+}
+
+int DatabaseManager::update_bulk_ids(const TaskPatch &patch)
+{
+    vector<string> assignments;
+    vector<int64_t> params;
+
+    if (patch.is_completed.has_value())
+    {
+        assignments.push_back("is_completed = ?");
+        params.push_back(patch.is_completed.value() ? 1 : 0);
+    }
+    if (patch.priority.has_value())
+    {
+        assignments.push_back("priority = ?");
+        params.push_back(patch.priority.value());
+    }
+    if (patch.status.has_value())
+    {
+        assignments.push_back("status = ?");
+        params.push_back(patch.status.value());
+    }
+    if (patch.progress.has_value())
+    {
+        assignments.push_back("progress = ?");
+        params.push_back(patch.progress.value());
+    }
+    if (patch.due_date.has_value())
+    {
+        assignments.push_back("due_date = ?");
+        params.push_back(static_cast<int64_t>(patch.due_date.value()));
+    }
+    else if (patch.clear_due_date)
+    {
+        assignments.push_back("due_date = NULL");
+    }
+
+    if (assignments.empty())
+    {
+        return 0;
+    }
+
+    string sql = "UPDATE tasks SET ";
+    for (size_t i = 0; i < assignments.size(); ++i)
+    {
+        sql += (i > 0 ? ", " : "") + assignments[i];
+    }
+    sql += ", updated_at = " + NOW_MS_SQL + " WHERE id IN (SELECT id FROM temp.bulk_task_ids)";
+
+    auto query = cached_statement(sql);
+    for (size_t i = 0; i < params.size(); ++i)
+    {
+        query->bind(static_cast<int>(i + 1), params[i]);
+    }
+    return query->exec();
+}
+
+int DatabaseManager::delete_bulk_ids(vector<int> *deleted_ids)
+{
+    if (deleted_ids)
+    {
+        deleted_ids->clear();
+        auto query = cached_statement("SELECT bulk_task_ids.id FROM temp.bulk_task_ids "
+                                      "JOIN tasks ON tasks.id = bulk_task_ids.id");
+        while (query->executeStep())
+        {
+            deleted_ids->push_back(query->getColumn(0).getInt());
+        }
+    }
+
+    // Foreign keys are not enforced, so dependent rows are removed explicitly
+    cached_statement("DELETE FROM task_links WHERE task_id IN (SELECT id FROM temp.bulk_task_ids)")->exec();
+    cached_statement("DELETE FROM task_tags WHERE task_id IN (SELECT id FROM temp.bulk_task_ids)")->exec();
+    return cached_statement("DELETE FROM tasks WHERE id IN (SELECT id FROM temp.bulk_task_ids)")->exec();
+}
+
+string DatabaseManager::filter_condition(const TaskFilter &filter, vector<int64_t> &params)
+{
+    vector<string> conditions;
+
+    if (filter.is_completed.has_value())
+    {
+        conditions.push_back("is_completed = ?");
+        params.push_back(filter.is_completed.value() ? 1 : 0);
+    }
+    if (filter.priority.has_value())
+    {
+        conditions.push_back("priority = ?");
+        params.push_back(filter.priority.value());
+    }
+    if (filter.status.has_value())
+    {
+        conditions.push_back("status = ?");
+        params.push_back(filter.status.value());
+    }
+    if (filter.parent_id.has_value())
+    {
+        conditions.push_back("parent_id = ?");
+        params.push_back(filter.parent_id.value());
+    }
+    if (filter.due_before.has_value())
+    {
+        conditions.push_back("due_date < ?");
+        params.push_back(static_cast<int64_t>(filter.due_before.value()));
+    }
+    if (filter.created_before.has_value())
+    {
+        conditions.push_back("created_at < ?");
+        params.push_back(static_cast<int64_t>(filter.created_before.value()));
+    }
+
+    string condition;
+    for (size_t i = 0; i < conditions.size(); ++i)
+    {
+        condition += (i > 0 ? " AND " : "") + conditions[i];
+    }
+    return condition;
+}
+
+vector<Task> DatabaseManager::get_tasks_by_priority(int priority)
+{
+    vector<Task> tasks;
+
+    bool ok = run_in_snapshot([&]()
+                              {
+        auto query = cached_statement(TASKS_BY_PRIORITY_SQL);
+
+        query->bind(1, priority);
+
+        while (query->executeStep())
+        {
+            tasks.push_back(read_task_row(*query));
+        }
+
+        auto bind_priority = [&](SQLite::Statement &details_query)
+        { details_query.bind(1, priority); };
+        load_links(tasks, "tasks.priority = ?", bind_priority);
+        load_tags(tasks, "tasks.priority = ?", bind_priority); });
+    if (!ok)
+    {
+        cerr << "Error getting tasks by priority" << endl;
+        tasks.clear();
+    }
+
+    return tasks;
+}
+
+vector<Task> DatabaseManager::get_overdue_tasks()
+{
+    vector<Task> tasks;
+
+    bool ok = run_in_snapshot([&]()
+                              {
+        time_t now = time(nullptr);
+        auto query = cached_statement(OVERDUE_TASKS_SQL);
+
+        query->bind(1, static_cast<int64_t>(now));
+
+        while (query->executeStep())
+        {
+            tasks.push_back(read_task_row(*query));
+        }
+
+        auto bind_now = [&](SQLite::Statement &details_query)
+        { details_query.bind(1, static_cast<int64_t>(now)); };
+        load_links(tasks, "tasks.due_date IS NOT NULL AND tasks.due_date < ? AND tasks.is_completed = 0", bind_now);
+        load_tags(tasks, "tasks.due_date IS NOT NULL AND tasks.due_date < ? AND tasks.is_completed = 0", bind_now); });
+    if (!ok)
+    {
+        cerr << "Error getting overdue tasks" << endl;
+        tasks.clear();
+    }
+
+    return tasks;
+}
+
+vector<Task> DatabaseManager::get_subtasks(int parent_id)
+{
+    vector<Task> tasks;
+
+    bool ok = run_in_snapshot([&]()
+                              {
+        auto query = cached_statement(SUBTASKS_SQL);
+
+        query->bind(1, parent_id);
+
+        while (query->executeStep())
+        {
+            tasks.push_back(read_task_row(*query));
+        }
+
+        auto bind_parent = [&](SQLite::Statement &details_query)
+        { details_query.bind(1, parent_id); };
+        load_links(tasks, "tasks.parent_id = ?", bind_parent);
+        load_tags(tasks, "tasks.parent_id = ?", bind_parent); });
+    if (!ok)
+    {
+        cerr << "Error getting subtasks" << endl;
+        tasks.clear();
+    }
+
+    return tasks;
+}
+
+/**
+ * @brief Turn user search text into an FTS5 query
+ * "quoted text" is matched as a phrase; every other word matches as a prefix.
+ * Terms are quoted so FTS5 operators typed by the user are taken literally.
+ */
+static string fts_query(const string &text)
+{
+    string query;
+    auto add_term = [&](const string &term, bool prefix)
+    {
+        if (term.empty())
+        {
+            return;
+        }
+        string quoted = "\"";
+        for (char c : term)
+        {
+            quoted += c == '"' ? string("\"\"") : string(1, c);
+        }
+        quoted += "\"";
+        query += (query.empty() ? "" : " ") + quoted + (prefix ? "*" : "");
+    };
+
+    string word;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        char c = text[i];
+        if (c == '"')
+        {
+            add_term(word, true);
+            word.clear();
+
+            size_t close = text.find('"', i + 1);
+            add_term(text.substr(i + 1, close == string::npos ? string::npos : close - i - 1), false);
+            i = close == string::npos ? text.size() : close;
+        }
+        else if (std::isspace(static_cast<unsigned char>(c)))
+        {
+            add_term(word, true);
+            word.clear();
+        }
+        else if (c != '*')
+        {
+            word += c;
+        }
+    }
+    add_term(word, true);
+
+    return query;
+}
+
+/**
+ * @brief Turn user search text into a LIKE pattern for the fallback search
+ * The whole text, without quotes, is matched as a substring; use ESCAPE '\\'.
+ * @return The pattern, or an empty string if nothing is left to match
+ */
+static string like_pattern(const string &text)
+{
+    string needle;
+    for (char c : text)
+    {
+        if (c == '%' || c == '_' || c == '\\')
+        {
+            needle += '\\';
+        }
+        if (c != '"' && c != '*')
+        {
+            needle += c;
+        }
+    }
+    return needle.empty() ? needle : "%" + needle + "%";
+}
+
+TaskDelta DatabaseManager::get_tasks_changed_since(int64_t since)
+{
+    TaskDelta delta;
+    delta.next_since = since;
+
+    // Both reads must see the same commits
+    bool ok = run_in_snapshot([&]()
+                              {
+        auto changed = cached_statement(CHANGED_TASKS_SQL);
+        changed->bind(1, since);
+        while (changed->executeStep())
+        {
+            Task task = read_task_row(*changed);
+            read_links_column(*changed, task);
+            read_tags_column(*changed, task);
+            delta.changed.push_back(std::move(task));
+            delta.next_since = std::max(delta.next_since, changed->getColumn(11).getInt64());
+        }
+
+        auto deleted = cached_statement(DELETED_TASKS_SQL);
+        deleted->bind(1, since);
+        while (deleted->executeStep())
+        {
+            delta.deleted_ids.push_back(deleted->getColumn(0).getInt());
+            delta.next_since = std::max(delta.next_since, deleted->getColumn(1).getInt64());
+        } });
+    if (!ok)
+    {
+        cerr << "Error getting changed tasks since " << since << endl;
+        delta.changed.clear();
+        delta.deleted_ids.clear();
+        delta.next_since = since;
+    }
+
+    return delta;
+}
+
+int64_t DatabaseManager::get_change_mark()
+{
+    try
+    {
+        auto query = cached_statement(CHANGE_MARK_SQL);
+        return query->executeStep() ? query->getColumn(0).getInt64() : 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error getting change mark: " << e.what() << endl;
+        return -1;
+    }
+}
+
+bool DatabaseManager::ensure_full_text_search()
+{
+    try
+    {
+        // Databases migrated by a build without FTS5 get the index once FTS5 is available
+        if (!db->tableExists("tasks_fts"))
+        {
+            run_in_transaction([&]()
+                               { return create_full_text_search(*db); });
+        }
+        full_text_search = db->tableExists("tasks_fts");
+        return full_text_search.value();
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error checking full-text search: " << e.what() << endl;
+        return false;
+    }
+}
+
+void DatabaseManager::prune_tombstones()
+{
+    try
+    {
+        auto query = cached_statement("DELETE FROM task_tombstones WHERE deleted_at < " + NOW_MS_SQL + " - ?");
+        query->bind(1, TOMBSTONE_RETENTION_MS);
+        query->exec();
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error pruning tombstones: " << e.what() << endl;
+    }
+}
+
+vector<Task> DatabaseManager::search_tasks(const string &text, int limit)
+{
+    vector<Task> tasks;
+
+    try
+    {
+        if (!full_text_search.has_value())
+        {
+            full_text_search = db->tableExists("tasks_fts");
+        }
+
+        if (full_text_search.value())
+        {
+            string match = fts_query(text);
+            if (match.empty())
+            {
+                return tasks;
+            }
+
+            // Description matches weigh more than link matches
+            auto query = cached_statement("SELECT tasks.id, tasks.description, is_completed, priority, created_at, due_date, parent_id, progress, status, "
+                                          "(SELECT group_concat(link, char(31)) FROM task_links WHERE task_id = tasks.id), " +
+                                          TASK_TAGS_COLUMN + " FROM tasks_fts JOIN tasks ON tasks.id = tasks_fts.rowid "
+                                          "WHERE tasks_fts MATCH ? ORDER BY bm25(tasks_fts, 10.0, 1.0) LIMIT ?");
+            query->bind(1, match);
+            query->bind(2, limit);
+
+            while (query->executeStep())
+            {
+                Task task = read_task_row(*query);
+                read_links_column(*query, task);
+                read_tags_column(*query, task);
+                tasks.push_back(std::move(task));
+            }
+        }
+        else
+        {
+            // Substring match on the whole text, without quotes
+            string needle = like_pattern(text);
+            if (needle.empty())
+            {
+                return tasks;
+            }
+
+            auto query = cached_statement(TASK_STREAM_SELECT + " WHERE description LIKE ?1 ESCAPE '\\' OR "
+                                          "EXISTS (SELECT 1 FROM task_links WHERE task_id = tasks.id AND link LIKE ?1 ESCAPE '\\')" +
+                                          TASK_KEYSET_ORDER + " LIMIT ?2");
+            query->bind(1, needle);
+            query->bind(2, limit);
+
+            while (query->executeStep())
+            {
+                Task task = read_task_row(*query);
+                read_links_column(*query, task);
+                read_tags_column(*query, task);
+                tasks.push_back(std::move(task));
+            }
+        }
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error searching tasks: " << e.what() << endl;
+    }
+
+    return tasks;
+}
+
+bool DatabaseManager::attach_archive(const string &archive_path)
+{
+    if (read_only || archive_attached)
+    {
+        return archive_attached;
+    }
+
+    try
+    {
+        SQLite::Statement attach(*db, "ATTACH DATABASE ? AS archive");
+        attach.bind(1, archive_path);
+        attach.exec();
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error attaching archive " << archive_path << ": " << e.what() << endl;
+        return false;
+    }
+
+    // Same columns as tasks plus the time of archiving; IDs keep their values
+    bool ok = run_in_transaction([&]()
+                                 {
+        db->exec("CREATE TABLE IF NOT EXISTS archive.tasks ("
+                 "id INTEGER PRIMARY KEY, "
+                 "description TEXT NOT NULL, "
+                 "is_completed INTEGER NOT NULL, "
+                 "priority INTEGER NOT NULL, "
+                 "created_at INTEGER NOT NULL, "
+                 "due_date INTEGER, "
+                 "parent_id INTEGER, "
+                 "progress INTEGER NOT NULL, "
+                 "status INTEGER NOT NULL, "
+                 "updated_at INTEGER NOT NULL, "
+                 "archived_at INTEGER NOT NULL"
+                 ");");
+        db->exec("CREATE TABLE IF NOT EXISTS archive.task_links ("
+                 "id INTEGER PRIMARY KEY, "
+                 "task_id INTEGER NOT NULL, "
+                 "link TEXT NOT NULL"
+                 ");");
+        db->exec("CREATE INDEX IF NOT EXISTS archive.idx_task_links_task_id ON task_links(task_id);");
+
+        // Tag IDs refer to main.tags; assignments of deleted tags are skipped when read
+        db->exec("CREATE TABLE IF NOT EXISTS archive.task_tags ("
+                 "task_id INTEGER NOT NULL, "
+                 "tag_id INTEGER NOT NULL, "
+                 "PRIMARY KEY (task_id, tag_id)"
+                 ");");
+        return true; });
+    if (!ok)
+    {
+        cerr << "Error creating archive schema in " << archive_path << endl;
+        db->exec("DETACH DATABASE archive");
+        return false;
+    }
+
+    // Archived rows never change, so the index is filled by archive_completed_tasks instead of
+    // triggers. An index created after tasks were archived without FTS5 is filled here first.
+    archive_full_text_search = run_in_transaction([&]()
+                                                  {
+        bool indexed = SQLite::Statement(*db, "SELECT 1 FROM archive.sqlite_master WHERE type = 'table' AND name = 'tasks_fts'").executeStep();
+        if (indexed)
+        {
+            return true;
+        }
+
+        try
+        {
+            db->exec("CREATE VIRTUAL TABLE archive.tasks_fts USING fts5(description, links, prefix = '2 3');");
+        }
+        catch (const exception &e)
+        {
+            cerr << "Warning: Full-text search unavailable in archive (" << e.what() << "), using LIKE search" << endl;
+            return false;
+        }
+        db->exec("INSERT INTO archive.tasks_fts (rowid, description, links) "
+                 "SELECT id, description, coalesce((SELECT group_concat(link, ' ') FROM archive.task_links WHERE task_id = a.id), '') "
+                 "FROM archive.tasks AS a;");
+        return true; });
+
+    archive_attached = true;
+    return true;
+}
+
+int DatabaseManager::archive_completed_tasks(time_t completed_before)
+{
+    if (!archive_attached)
+    {
+        return 0;
+    }
+
+    const int64_t cutoff = static_cast<int64_t>(completed_before) * 1000;
+    int archived = 0;
+
+    // Copy, commit, then delete: in WAL mode a commit is only atomic per file, so the copy
+    // must be durable before the tasks leave the hot table
+    bool copied = run_in_transaction([&]()
+                                     {
+        db->exec("CREATE TEMP TABLE IF NOT EXISTS archive_task_ids (id INTEGER PRIMARY KEY, root INTEGER NOT NULL, stale INTEGER NOT NULL)");
+        db->exec("DELETE FROM temp.archive_task_ids");
+
+        auto candidates = cached_statement(ARCHIVE_CANDIDATES_SQL);
+        candidates->bind(1, cutoff);
+        candidates->exec();
+
+        // Whole trees only: one open or recently changed task keeps its tree hot
+        auto open_trees = cached_statement(ARCHIVE_OPEN_TREES_SQL);
+        open_trees->bind(1, cutoff);
+        open_trees->exec();
+
+        vector<string> copy = {
+            "INSERT OR REPLACE INTO archive.tasks (" + ARCHIVE_TASK_COLUMNS + ", archived_at) "
+            "SELECT " + ARCHIVE_TASK_COLUMNS + ", " + NOW_MS_SQL + " FROM main.tasks WHERE id IN " + ARCHIVE_IDS,
+            "DELETE FROM archive.task_links WHERE task_id IN " + ARCHIVE_IDS,
+            "INSERT INTO archive.task_links (id, task_id, link) SELECT id, task_id, link FROM main.task_links WHERE task_id IN " + ARCHIVE_IDS,
+            "DELETE FROM archive.task_tags WHERE task_id IN " + ARCHIVE_IDS,
+            "INSERT INTO archive.task_tags (task_id, tag_id) SELECT task_id, tag_id FROM main.task_tags WHERE task_id IN " + ARCHIVE_IDS,
+        };
+        if (archive_full_text_search)
+        {
+            copy.push_back("DELETE FROM archive.tasks_fts WHERE rowid IN " + ARCHIVE_IDS);
+            copy.push_back("INSERT INTO archive.tasks_fts (rowid, description, links) "
+                           "SELECT id, description, coalesce((SELECT group_concat(link, ' ') FROM main.task_links WHERE task_id = tasks.id), '') "
+                           "FROM main.tasks WHERE id IN " + ARCHIVE_IDS);
+        }
+        for (const auto &sql : copy)
+        {
+            cached_statement(sql)->exec();
+        }
+        return true; });
+    if (!copied)
+    {
+        cerr << "Error copying tasks to the archive" << endl;
+        return -1;
+    }
+
+    bool moved = run_in_transaction([&]()
+                                    {
+        // Another process may have changed a tree since the copy, or added a subtask
+        // to it that deleting the tree would orphan; such a tree stays hot and its copy goes
+        cached_statement(ARCHIVE_STALE_TREES_SQL)->exec();
+        cached_statement(ARCHIVE_GROWN_TREES_SQL)->exec();
+
+        vector<string> drop_stale = {
+            "DELETE FROM archive.task_links WHERE task_id IN " + ARCHIVE_STALE_IDS,
+            "DELETE FROM archive.task_tags WHERE task_id IN " + ARCHIVE_STALE_IDS,
+            "DELETE FROM archive.tasks WHERE id IN " + ARCHIVE_STALE_IDS,
+        };
+        if (archive_full_text_search)
+        {
+            drop_stale.push_back("DELETE FROM archive.tasks_fts WHERE rowid IN " + ARCHIVE_STALE_IDS);
+        }
+        for (const auto &sql : drop_stale)
+        {
+            cached_statement(sql)->exec();
+        }
+
+        // Foreign keys are not enforced, so dependent rows are removed explicitly
+        cached_statement("DELETE FROM main.task_links WHERE task_id IN " + ARCHIVE_IDS)->exec();
+        cached_statement("DELETE FROM main.task_tags WHERE task_id IN " + ARCHIVE_IDS)->exec();
+        archived = cached_statement("DELETE FROM main.tasks WHERE id IN " + ARCHIVE_IDS)->exec();
+        return true; });
+    if (!moved)
+    {
+        cerr << "Error removing archived tasks from the task list" << endl;
+        return -1;
+    }
+
+    return archived;
+}
+
+vector<Task> DatabaseManager::search_archive(const string &text, int limit)
+{
+    vector<Task> tasks;
+    if (!archive_attached)
+    {
+        return tasks;
+    }
 
-        // Migration: Add progress column if it doesn't exist (for existing databases)
-        try
-        {
-            SQLite::Statement check(*db, "SELECT progress FROM tasks LIMIT 1");
-        }
-        catch (const exception &)
+    try
+    {
+        // Most recently completed first when there is no ranking
+        string pattern = archive_full_text_search ? fts_query(text) : like_pattern(text);
+        string sql = archive_full_text_search
+                         ? ARCHIVE_SELECT + " FROM archive.tasks_fts JOIN archive.tasks AS a ON a.id = tasks_fts.rowid "
+                                            "WHERE tasks_fts MATCH ?1 AND " +
+                               ARCHIVE_NOT_HOT + " ORDER BY bm25(tasks_fts, 10.0, 1.0) LIMIT ?2"
+                         : ARCHIVE_SELECT + " FROM archive.tasks AS a "
+                                            "WHERE (a.description LIKE ?1 ESCAPE '\\' OR "
+                                            "EXISTS (SELECT 1 FROM archive.task_links WHERE task_id = a.id AND link LIKE ?1 ESCAPE '\\')) AND " +
+                               ARCHIVE_NOT_HOT + " ORDER BY a.updated_at DESC LIMIT ?2";
+        if (pattern.empty())
         {
-            // Column doesn't exist, add it
-            cout << "Migrating database: Adding progress column..." << endl;
-            db->exec("ALTER TABLE tasks ADD COLUMN progress INTEGER NOT NULL DEFAULT 0;");
-            cout << "Migration complete." << endl;
+            return tasks;
         }
 
-        // Migration: Add status column if it doesn't exist
-        try
-        {
-            SQLite::Statement check(*db, "SELECT status FROM tasks LIMIT 1");
-        }
-        catch (const exception &)
+        auto query = cached_statement(sql);
+        query->bind(1, pattern);
+        query->bind(2, limit);
+
+        while (query->executeStep())
         {
-            cout << "Migrating database: Adding status column..." << endl;
-            db->exec("ALTER TABLE tasks ADD COLUMN status INTEGER NOT NULL DEFAULT 0;");
-            cout << "Migration complete." << endl;
+            Task task = read_task_row(*query);
+            read_links_column(*query, task);
+            read_tags_column(*query, task);
+            tasks.push_back(std::move(task));
         }
-
-        cout << "Database initialized successfully." << endl;
     }
     catch (const exception &e)
     {
-        cerr << "Error initializing database: " << e.what() << endl;
-        throw;
+        cerr << "Error searching archive: " << e.what() << endl;
     }
+
+    return tasks;
 }
 
-int DatabaseManager::add_task(const Task &task)
+TaskPage DatabaseManager::get_tasks_page(const optional<TaskCursor> &after, int limit, bool include_completed)
 {
-    try
-    {
-        SQLite::Statement query(*db,
-                                "INSERT INTO tasks (description, is_completed, priority, created_at, due_date, parent_id, progress, status) "
-                                "VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
-
-        query.bind(1, task.description);
-        query.bind(2, task.is_completed ? 1 : 0);
-        query.bind(3, task.priority);
-        query.bind(4, static_cast<int64_t>(task.created_at));
+    TaskPage page;
 
-        if (task.due_date.has_value())
+    // A page can take several range queries; they must see the same commits
+    bool ok = run_in_snapshot([&]()
+                              {
+        vector<KeysetRange> ranges;
+        if (!after.has_value())
         {
-            query.bind(5, static_cast<int64_t>(task.due_date.value()));
+            ranges = {KeysetRange::First};
         }
-        else
+        else if (after->due_date.has_value())
         {
-            query.bind(5); // NULL
+            ranges = {KeysetRange::SameDue, KeysetRange::LaterDue, KeysetRange::LowerPriority};
         }
-
-        if (task.parent_id.has_value())
+        else
         {
-            query.bind(6, task.parent_id.value());
+            ranges = {KeysetRange::SameDue, KeysetRange::AnyDue, KeysetRange::LowerPriority};
         }
-        else
+
+        page.tasks.reserve(limit > 0 ? limit : 0);
+        for (KeysetRange range : ranges)
         {
-            query.bind(6); // NULL
+            int remaining = limit - static_cast<int>(page.tasks.size());
+            if (remaining <= 0)
+            {
+                break;
+            }
+
+            auto query = cached_statement(task_page_sql(include_completed, range));
+            if (range != KeysetRange::First)
+            {
+                query->bind(":priority", after->priority);
+            }
+            if (range == KeysetRange::SameDue || range == KeysetRange::LaterDue)
+            {
+                if (after->due_date.has_value())
+                {
+                    query->bind(":due_date", static_cast<int64_t>(after->due_date.value()));
+                }
+                else
+                {
+                    query->bind(":due_date"); // NULL
+                }
+            }
+            if (range == KeysetRange::SameDue)
+            {
+                query->bind(":id", after->id);
+            }
+            query->bind(":limit", remaining);
+
+            while (query->executeStep())
+            {
+                Task task = read_task_row(*query);
+                read_links_column(*query, task);
+                read_tags_column(*query, task);
+                page.tasks.push_back(std::move(task));
+            }
         }
 
-        query.bind(7, task.progress);
-        query.bind(8, task.status);
+        // A full page may have more rows behind it
+        if (limit > 0 && static_cast<int>(page.tasks.size()) == limit)
+        {
+            const Task &last = page.tasks.back();
+            page.next = TaskCursor{last.priority, last.due_date, last.id};
+        } });
+    if (!ok)
+    {
+        cerr << "Error getting task page" << endl;
+        page.tasks.clear();
+        page.next.reset();
+    }
 
-        query.exec();
+    return page;
+}
 
-        int task_id = static_cast<int>(db->getLastInsertRowid());
+bool DatabaseManager::for_each_task(const function<bool(const Task &)> &visitor, bool include_completed)
+{
+    try
+    {
+        string sql = TASK_LINK_JOIN_SELECT;
+        if (!include_completed)
+        {
+            sql += " WHERE is_completed = 0";
+        }
+        auto query = cached_statement(sql + TASK_LINK_JOIN_ORDER);
 
-        // Add links
-        for (const auto &link : task.links)
+        // Only the task being assembled is held in memory
+        optional<Task> current;
+        while (query->executeStep())
         {
-            add_task_link(task_id, link);
+            int task_id = query->getColumn(0).getInt();
+            if (!current.has_value() || current->id != task_id)
+            {
+                if (current.has_value() && !visitor(current.value()))
+                {
+                    return true;
+                }
+                current = read_task_row(*query);
+                read_tags_column(*query, current.value());
+            }
+
+            if (!query->getColumn(9).isNull())
+            {
+                current->links.push_back(query->getColumn(9).getText());
+            }
         }
 
-        return task_id;
+        if (current.has_value())
+        {
+            visitor(current.value());
+        }
+        return true;
     }
     catch (const exception &e)
     {
-        cerr << "Error adding task: " << e.what() << endl;
-        return -1;
+        cerr << "Error iterating tasks: " << e.what() << endl;
+        return false;
     }
 }
 
-vector<Task> DatabaseManager::get_all_tasks(bool include_completed)
+unordered_map<int, SubtaskCounts> DatabaseManager::get_subtask_counts()
 {
-    vector<Task> tasks;
+    unordered_map<int, SubtaskCounts> counts;
 
     try
     {
-        string query_str = "SELECT id, description, is_completed, priority, created_at, due_date, parent_id, progress, status FROM tasks";
+        auto query = cached_statement(SUBTASK_COUNTS_SQL);
 
-        if (!include_completed)
+        while (query->executeStep())
         {
-            query_str += " WHERE is_completed = 0";
+            SubtaskCounts &entry = counts[query->getColumn(0).getInt()];
+            entry.completed = query->getColumn(1).getInt();
+            entry.total = query->getColumn(2).getInt();
         }
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error getting subtask counts: " << e.what() << endl;
+    }
 
-        query_str += " ORDER BY priority DESC, due_date ASC";
+    return counts;
+}
 
-        SQLite::Statement query(*db, query_str);
+bool DatabaseManager::add_task_link(int task_id, const string &link)
+{
+    try
+    {
+        TransactionScope transaction(*this);
+        auto query = cached_statement("INSERT INTO task_links (task_id, link) VALUES (?, ?)");
 
-        while (query.executeStep())
-        {
-            Task task;
-            task.id = query.getColumn(0).getInt();
-            task.description = query.getColumn(1).getText();
-            task.is_completed = query.getColumn(2).getInt() != 0;
-            task.priority = query.getColumn(3).getInt();
-            task.created_at = static_cast<time_t>(query.getColumn(4).getInt64());
+        query->bind(1, task_id);
+        query->bind(2, link);
+        query->exec();
 
-            if (!query.getColumn(5).isNull())
-            {
-                task.due_date = static_cast<time_t>(query.getColumn(5).getInt64());
-            }
+        note_task_change(TaskChangeType::Updated, task_id);
+        transaction.commit();
+        return true;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error adding task link: " << e.what() << endl;
+        return false;
+    }
+}
 
-            if (!query.getColumn(6).isNull())
-            {
-                task.parent_id = query.getColumn(6).getInt();
-            }
+vector<string> DatabaseManager::get_task_links(int task_id)
+{
+    vector<string> links;
 
-            task.progress = query.getColumn(7).getInt();
-            task.status = query.getColumn(8).getInt();
+    try
+    {
+        auto query = cached_statement(TASK_LINKS_SQL);
 
-            // Load links
-            task.links = get_task_links(task.id);
+        query->bind(1, task_id);
 
-            tasks.push_back(task);
+        while (query->executeStep())
+        {
+            links.push_back(query->getColumn(0).getText());
         }
     }
     catch (const exception &e)
     {
-        cerr << "Error getting all tasks: " << e.what() << endl;
+        cerr << "Error getting task links: " << e.what() << endl;
     }
 
-    return tasks;
+    return links;
 }
 
-optional<Task> DatabaseManager::get_task_by_id(int task_id)
+int DatabaseManager::add_tag(const string &name)
 {
     try
     {
-        SQLite::Statement query(*db,
-                                "SELECT id, description, is_completed, priority, created_at, due_date, parent_id, progress, status "
-                                "FROM tasks WHERE id = ?");
-
-        query.bind(1, task_id);
+        // The insert and the lookup see the same row
+        TransactionScope transaction(*this);
 
-        if (query.executeStep())
-        {
-            Task task;
-            task.id = query.getColumn(0).getInt();
-            task.description = query.getColumn(1).getText();
-            task.is_completed = query.getColumn(2).getInt() != 0;
-            task.priority = query.getColumn(3).getInt();
-            task.created_at = static_cast<time_t>(query.getColumn(4).getInt64());
+        // Existing names keep their ID
+        auto insert = cached_statement("INSERT OR IGNORE INTO tags (name) VALUES (?)");
+        insert->bind(1, name);
+        insert->exec();
 
-            if (!query.getColumn(5).isNull())
-            {
-                task.due_date = static_cast<time_t>(query.getColumn(5).getInt64());
-            }
+        auto query = cached_statement(TAG_BY_NAME_SQL);
+        query->bind(1, name);
+        int tag_id = query->executeStep() ? query->getColumn(0).getInt() : -1;
+        query->reset();
 
-            if (!query.getColumn(6).isNull())
-            {
-                task.parent_id = query.getColumn(6).getInt();
-            }
+        transaction.commit();
+        return tag_id;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error adding tag: " << e.what() << endl;
+        return -1;
+    }
+}
 
-            task.progress = query.getColumn(7).getInt();
-            task.status = query.getColumn(8).getInt();
+vector<Tag> DatabaseManager::get_all_tags()
+{
+    vector<Tag> tags;
 
-            // Load links
-            task.links = get_task_links(task.id);
+    try
+    {
+        auto query = cached_statement(ALL_TAGS_SQL);
 
-            return task;
+        while (query->executeStep())
+        {
+            tags.push_back(Tag{query->getColumn(0).getInt(), query->getColumn(1).getText()});
         }
     }
     catch (const exception &e)
     {
-        cerr << "Error getting task by ID: " << e.what() << endl;
+        cerr << "Error getting tags: " << e.what() << endl;
     }
 
-    return std::nullopt;
+    return tags;
 }
 
-bool DatabaseManager::update_task(const Task &task)
+bool DatabaseManager::rename_tag(int tag_id, const string &name)
 {
     try
     {
-        SQLite::Statement query(*db,
-                                "UPDATE tasks SET description = ?, is_completed = ?, priority = ?, "
-                                "due_date = ?, parent_id = ?, progress = ?, status = ? WHERE id = ?");
+        TransactionScope transaction(*this);
 
-        query.bind(1, task.description);
-        query.bind(2, task.is_completed ? 1 : 0);
-        query.bind(3, task.priority);
+        auto query = cached_statement("UPDATE tags SET name = ? WHERE id = ?");
 
-        if (task.due_date.has_value())
-        {
-            query.bind(4, static_cast<int64_t>(task.due_date.value()));
-        }
-        else
-        {
-            query.bind(4); // NULL
-        }
+        query->bind(1, name);
+        query->bind(2, tag_id);
+        int renamed = query->exec();
 
-        if (task.parent_id.has_value())
-        {
-            query.bind(5, task.parent_id.value());
-        }
-        else
+        // The tag is shown with its tasks: touching them reports each as updated
+        // to this process's listeners and to readers of the change mark
+        auto touch = cached_statement("UPDATE tasks SET updated_at = " + NOW_MS_SQL + " WHERE id IN (SELECT task_id FROM task_tags WHERE tag_id = ?)");
+        touch->bind(1, tag_id);
+        touch->exec();
+
+        transaction.commit();
+        return renamed > 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error renaming tag: " << e.what() << endl;
+        return false;
+    }
+}
+
+bool DatabaseManager::delete_tag(int tag_id)
+{
+    try
+    {
+        // Foreign keys are not enforced, so assignments are removed explicitly
+        TransactionScope transaction(*this);
+
+        auto tagged = cached_statement("SELECT task_id FROM task_tags WHERE tag_id = ?");
+        tagged->bind(1, tag_id);
+        while (tagged->executeStep())
         {
-            query.bind(5); // NULL
+            note_task_change(TaskChangeType::Updated, tagged->getColumn(0).getInt());
         }
 
-        query.bind(6, task.progress);
-        query.bind(7, task.status);
-        query.bind(8, task.id);
+        auto unassign = cached_statement("DELETE FROM task_tags WHERE tag_id = ?");
+        unassign->bind(1, tag_id);
+        unassign->exec();
 
-        query.exec();
+        auto query = cached_statement("DELETE FROM tags WHERE id = ?");
+        query->bind(1, tag_id);
+        int deleted = query->exec();
 
-        return true;
+        transaction.commit();
+        return deleted > 0;
     }
     catch (const exception &e)
     {
-        cerr << "Error updating task: " << e.what() << endl;
+        cerr << "Error deleting tag: " << e.what() << endl;
         return false;
     }
 }
 
-bool DatabaseManager::delete_task(int task_id)
+bool DatabaseManager::set_task_tags(int task_id, const vector<int> &tag_ids)
 {
     try
     {
-        SQLite::Statement query(*db, "DELETE FROM tasks WHERE id = ?");
-        query.bind(1, task_id);
-        query.exec();
+        TransactionScope transaction(*this);
+        replace_task_tags(task_id, tag_ids);
+        note_task_change(TaskChangeType::Updated, task_id);
+        transaction.commit();
+
         return true;
     }
     catch (const exception &e)
     {
-        cerr << "Error deleting task: " << e.what() << endl;
+        cerr << "Error setting task tags: " << e.what() << endl;
         return false;
     }
 }
 
-vector<Task> DatabaseManager::get_tasks_by_priority(int priority)
+vector<int> DatabaseManager::get_task_tags(int task_id)
 {
-    vector<Task> tasks;
+    vector<int> tag_ids;
 
     try
     {
-        SQLite::Statement query(*db,
-                                "SELECT id, description, is_completed, priority, created_at, due_date, parent_id, progress, status "
-                                "FROM tasks WHERE priority = ? ORDER BY due_date ASC");
+        auto query = cached_statement(TASK_TAGS_SQL);
 
-        query.bind(1, priority);
+        query->bind(1, task_id);
 
-        while (query.executeStep())
+        while (query->executeStep())
         {
-            Task task;
-            task.id = query.getColumn(0).getInt();
-            task.description = query.getColumn(1).getText();
-            task.is_completed = query.getColumn(2).getInt() != 0;
-            task.priority = query.getColumn(3).getInt();
-            task.created_at = static_cast<time_t>(query.getColumn(4).getInt64());
-
-            if (!query.getColumn(5).isNull())
-            {
-                task.due_date = static_cast<time_t>(query.getColumn(5).getInt64());
-            }
-
-            if (!query.getColumn(6).isNull())
-            {
-                task.parent_id = query.getColumn(6).getInt();
-            }
-
-            task.progress = query.getColumn(7).getInt();
-            task.status = query.getColumn(8).getInt();
-
-            task.links = get_task_links(task.id);
-            tasks.push_back(task);
+            tag_ids.push_back(query->getColumn(0).getInt());
         }
     }
     catch (const exception &e)
     {
-        cerr << "Error getting tasks by priority: " << e.what() << endl;
+        cerr << "Error getting task tags: " << e.what() << endl;
     }
 
-    return tasks;
+    return tag_ids;
 }
 
-vector<Task> DatabaseManager::get_overdue_tasks()
+void DatabaseManager::replace_task_tags(int task_id, const vector<int> &tag_ids)
 {
-    vector<Task> tasks;
-
-    try
-    {
-        time_t now = time(nullptr);
-        SQLite::Statement query(*db,
-                                "SELECT id, description, is_completed, priority, created_at, due_date, parent_id, progress, status "
-                                "FROM tasks WHERE due_date IS NOT NULL AND due_date < ? AND is_completed = 0 "
-                                "ORDER BY due_date ASC");
+    auto query = cached_statement("DELETE FROM task_tags WHERE task_id = ?");
+    query->bind(1, task_id);
+    query->exec();
 
-        query.bind(1, static_cast<int64_t>(now));
+    insert_task_tags(task_id, tag_ids);
+}
 
-        while (query.executeStep())
-        {
-            Task task;
-            task.id = query.getColumn(0).getInt();
-            task.description = query.getColumn(1).getText();
-            task.is_completed = query.getColumn(2).getInt() != 0;
-            task.priority = query.getColumn(3).getInt();
-            task.created_at = static_cast<time_t>(query.getColumn(4).getInt64());
+string DatabaseManager::get_statement_cache_stats() const
+{
+    stringstream ss;
+    long long total = statement_cache_hits + statement_cache_misses;
+    float hit_rate = total > 0 ? (float)statement_cache_hits / total * 100.0f : 0.0f;
 
-            if (!query.getColumn(5).isNull())
-            {
-                task.due_date = static_cast<time_t>(query.getColumn(5).getInt64());
-            }
+    ss << "Statement Cache Statistics:\n";
+    ss << "  Cached statements: " << statement_cache.size() << "\n";
+    ss << "  Hits: " << statement_cache_hits << "\n";
+    ss << "  Misses: " << statement_cache_misses << "\n";
+    ss << "  Hit Rate: " << hit_rate << "%\n";
 
-            if (!query.getColumn(6).isNull())
-            {
-                task.parent_id = query.getColumn(6).getInt();
-            }
+    return ss.str();
+}
 
-            task.progress = query.getColumn(7).getInt();
-            task.status = query.getColumn(8).getInt();
-            task.links = get_task_links(task.id);
-            tasks.push_back(task);
-        }
+DatabaseManager::StatementLease DatabaseManager::cached_statement(const string &sql)
+{
+    auto it = statement_cache.find(sql);
+    if (it == statement_cache.end())
+    {
+        statement_cache_misses++;
+        CachedStatementEntry entry;
+        entry.statement = make_unique<SQLite::Statement>(*db, sql);
+        it = statement_cache.emplace(sql, std::move(entry)).first;
     }
-    catch (const exception &e)
+    else if (it->second.in_use)
+    {
+        // Same query re-entered while borrowed: use a throwaway statement
+        statement_cache_misses++;
+        return StatementLease(make_unique<SQLite::Statement>(*db, sql));
+    }
+    else
     {
-        cerr << "Error getting overdue tasks: " << e.what() << endl;
+        statement_cache_hits++;
     }
 
-    return tasks;
+    return StatementLease(*it->second.statement, &it->second.in_use);
 }
 
-vector<Task> DatabaseManager::get_subtasks(int parent_id)
+DatabaseManager::StatementLease::StatementLease(SQLite::Statement &statement, bool *in_use)
+    : statement(&statement), in_use(in_use)
 {
-    vector<Task> tasks;
+    *in_use = true;
+}
+
+DatabaseManager::StatementLease::StatementLease(unique_ptr<SQLite::Statement> owned_statement)
+    : statement(owned_statement.get()), in_use(nullptr), owned(std::move(owned_statement))
+{
+}
+
+DatabaseManager::StatementLease::StatementLease(StatementLease &&other) noexcept
+    : statement(other.statement), in_use(other.in_use), owned(std::move(other.owned))
+{
+    other.statement = nullptr;
+    other.in_use = nullptr;
+}
+
+DatabaseManager::StatementLease::~StatementLease()
+{
+    if (statement == nullptr || owned)
+    {
+        return;
+    }
 
     try
     {
-        SQLite::Statement query(*db,
-                                "SELECT id, description, is_completed, priority, created_at, due_date, parent_id, progress, status "
-                                "FROM tasks WHERE parent_id = ? ORDER BY priority DESC");
+        statement->reset();
+        statement->clearBindings();
+    }
+    catch (const exception &)
+    {
+        // The statement's last error was already reported by its caller
+    }
+    *in_use = false;
+}
 
-        query.bind(1, parent_id);
+Task DatabaseManager::read_task_row(SQLite::Statement &query)
+{
+    Task task;
+    task.id = query.getColumn(0).getInt();
+    task.description = query.getColumn(1).getText();
+    task.is_completed = query.getColumn(2).getInt() != 0;
+    task.priority = query.getColumn(3).getInt();
+    task.created_at = static_cast<time_t>(query.getColumn(4).getInt64());
+
+    if (!query.getColumn(5).isNull())
+    {
+        task.due_date = static_cast<time_t>(query.getColumn(5).getInt64());
+    }
 
-        while (query.executeStep())
-        {
-            Task task;
-            task.id = query.getColumn(0).getInt();
-            task.description = query.getColumn(1).getText();
-            task.is_completed = query.getColumn(2).getInt() != 0;
-            task.priority = query.getColumn(3).getInt();
-            task.created_at = static_cast<time_t>(query.getColumn(4).getInt64());
+    if (!query.getColumn(6).isNull())
+    {
+        task.parent_id = query.getColumn(6).getInt();
+    }
 
-            if (!query.getColumn(5).isNull())
-            {
-                task.due_date = static_cast<time_t>(query.getColumn(5).getInt64());
-            }
+    task.progress = query.getColumn(7).getInt();
+    task.status = query.getColumn(8).getInt();
 
-            if (!query.getColumn(6).isNull())
-            {
-                task.parent_id = query.getColumn(6).getInt();
-            }
+    return task;
+}
 
-            task.progress = query.getColumn(7).getInt();
-            task.status = query.getColumn(8).getInt();
+void DatabaseManager::read_links_column(SQLite::Statement &query, Task &task)
+{
+    if (query.getColumn(9).isNull())
+    {
+        return;
+    }
 
-            task.links = get_task_links(task.id);
-            tasks.push_back(task);
+    string joined = query.getColumn(9).getText();
+    size_t start = 0;
+    while (true)
+    {
+        size_t end = joined.find(LINK_SEPARATOR, start);
+        task.links.push_back(joined.substr(start, end == string::npos ? string::npos : end - start));
+        if (end == string::npos)
+        {
+            break;
         }
+        start = end + 1;
     }
-    catch (const exception &e)
+}
+
+void DatabaseManager::read_tags_column(SQLite::Statement &query, Task &task)
+{
+    if (query.getColumn(10).isNull())
     {
-        cerr << "Error getting subtasks: " << e.what() << endl;
+        return;
     }
 
-    return tasks;
+    stringstream joined(query.getColumn(10).getText());
+    string tag_id;
+    while (std::getline(joined, tag_id, ','))
+    {
+        task.tags.push_back(std::stoi(tag_id));
+    }
 }
 
-bool DatabaseManager::add_task_link(int task_id, const string &link)
+string DatabaseManager::links_sql(const string &task_filter)
 {
-    try
+    // A single join restricted by the same filter as the task query
+    string query_str = "SELECT task_links.task_id, task_links.link FROM task_links "
+                       "JOIN tasks ON tasks.id = task_links.task_id";
+
+    if (!task_filter.empty())
     {
-        SQLite::Statement query(*db,
-                                "INSERT INTO task_links (task_id, link) VALUES (?, ?)");
+        query_str += " WHERE " + task_filter;
+    }
 
-        query.bind(1, task_id);
-        query.bind(2, link);
-        query.exec();
+    query_str += " ORDER BY task_links.task_id, task_links.id";
+    return query_str;
+}
 
-        return true;
+void DatabaseManager::load_links(vector<Task> &tasks, const string &task_filter,
+                                 const function<void(SQLite::Statement &)> &bind_filter)
+{
+    if (tasks.empty())
+    {
+        return;
     }
-    catch (const exception &e)
+
+    // Map task IDs to their position so link rows can be stitched in place
+    unordered_map<int, size_t> index_by_id;
+    index_by_id.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i)
     {
-        cerr << "Error adding task link: " << e.what() << endl;
-        return false;
+        index_by_id[tasks[i].id] = i;
+    }
+
+    auto query = cached_statement(links_sql(task_filter));
+
+    if (bind_filter)
+    {
+        bind_filter(*query);
+    }
+
+    while (query->executeStep())
+    {
+        auto it = index_by_id.find(query->getColumn(0).getInt());
+        if (it != index_by_id.end())
+        {
+            tasks[it->second].links.push_back(query->getColumn(1).getText());
+        }
     }
 }
 
-vector<string> DatabaseManager::get_task_links(int task_id)
+string DatabaseManager::tags_sql(const string &task_filter)
 {
-    vector<string> links;
+    string query_str = "SELECT task_tags.task_id, task_tags.tag_id FROM task_tags "
+                       "JOIN tasks ON tasks.id = task_tags.task_id";
 
-    try
+    if (!task_filter.empty())
     {
-        SQLite::Statement query(*db,
-                                "SELECT link FROM task_links WHERE task_id = ?");
+        query_str += " WHERE " + task_filter;
+    }
+
+    query_str += " ORDER BY task_tags.task_id, task_tags.tag_id";
+    return query_str;
+}
 
-        query.bind(1, task_id);
+void DatabaseManager::load_tags(vector<Task> &tasks, const string &task_filter,
+                                const function<void(SQLite::Statement &)> &bind_filter)
+{
+    if (tasks.empty())
+    {
+        return;
+    }
 
-        while (query.executeStep())
-        {
-            links.push_back(query.getColumn(0).getText());
-        }
+    unordered_map<int, size_t> index_by_id;
+    index_by_id.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        index_by_id[tasks[i].id] = i;
     }
-    catch (const exception &e)
+
+    auto query = cached_statement(tags_sql(task_filter));
+
+    if (bind_filter)
     {
-        cerr << "Error getting task links: " << e.what() << endl;
+        bind_filter(*query);
     }
 
-    return links;
+    while (query->executeStep())
+    {
+        auto it = index_by_id.find(query->getColumn(0).getInt());
+        if (it != index_by_id.end())
+        {
+            tasks[it->second].tags.push_back(query->getColumn(1).getInt());
+        }
+    }
 }
@@ -4,29 +4,180 @@
 #include <vector>
 #include <optional>
 #include <memory>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+#include <utility>
 #include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+#include "SqliteProfile.hpp"
 #include "Task.hpp"
 
+using std::function;
 using std::optional;
+using std::pair;
 using std::string;
 using std::unique_ptr;
+using std::unordered_map;
 using std::vector;
 
+/**
+ * @brief Completed and total subtask counts for one parent task
+ */
+struct SubtaskCounts
+{
+    int completed = 0; // Subtasks marked completed (or with Completed status)
+    int total = 0;     // All subtasks of the parent
+};
+
+/**
+ * @brief A named label that can be attached to any number of tasks
+ */
+struct Tag
+{
+    int id = 0;
+    string name;
+};
+
+/**
+ * @brief Fields to change in a bulk update; unset fields are left alone
+ */
+struct TaskPatch
+{
+    optional<bool> is_completed;
+    optional<int> priority;
+    optional<int> status;
+    optional<int> progress;
+    optional<time_t> due_date;
+    bool clear_due_date = false; // Set due_date to NULL (ignored if due_date is set)
+};
+
+/**
+ * @brief Predicate selecting tasks for bulk operations; unset fields match everything
+ */
+struct TaskFilter
+{
+    optional<bool> is_completed;
+    optional<int> priority;
+    optional<int> status;
+    optional<int> parent_id;
+    optional<time_t> due_before;     // due_date < value (tasks without due date never match)
+    optional<time_t> created_before; // created_at < value
+};
+
+/**
+ * @brief Position in the task list order (priority DESC, due_date ASC, id ASC)
+ */
+struct TaskCursor
+{
+    int priority = 0;
+    optional<time_t> due_date;
+    int id = 0;
+};
+
+/**
+ * @brief Tasks changed since a point in time, from get_tasks_changed_since
+ */
+struct TaskDelta
+{
+    vector<Task> changed;    // Inserted or updated tasks with links and tags, oldest change first
+    vector<int> deleted_ids; // Tasks deleted since then
+    int64_t next_since = 0;  // Pass to the next call to continue from here
+};
+
+/**
+ * @brief One page of tasks from get_tasks_page
+ */
+struct TaskPage
+{
+    vector<Task> tasks;        // Tasks in list order, links and tags loaded
+    optional<TaskCursor> next; // Pass to get_tasks_page for the following page; empty on the last page
+};
+
 class DatabaseManager
 {
 public:
+    /**
+     * @brief Receives the task changes of one commit, at most one entry per task
+     */
+    using TaskChangeListener = function<void(const vector<TaskChange> &)>;
+
     /**
      * @brief Constructor that opens or creates a database.
      * @param db_path The file path to the database (e.g., "tasks.db").
+     * @param profile Journal, sync, cache and locking settings applied after opening
+     * @param read_only Open an existing database for reading only (journal_mode is left alone)
+     */
+    DatabaseManager(const string &db_path, const SqliteProfile &profile = SqliteProfile(), bool read_only = false);
+
+    /**
+     * @brief Destructor - detach the change hooks before the connection closes
      */
-    DatabaseManager(const string &db_path);
+    ~DatabaseManager();
 
     /**
      * @brief Initialize the database schema
-     * Creates all necessary tables if they don't exist
+     * Applies every migration newer than the stored schema version (PRAGMA user_version),
+     * each in its own transaction. An up-to-date database costs a single pragma read.
      */
     void initilize_database();
 
+    /**
+     * @brief Get the schema version stored in the database file
+     * @return The value of PRAGMA user_version (0 for a new or pre-versioning database)
+     */
+    int get_schema_version();
+
+    /**
+     * @brief Read PRAGMA data_version
+     * The value changes whenever another connection (or process) commits, but
+     * not for commits made through this connection.
+     * @return The data version, or -1 on error
+     */
+    long long get_data_version();
+
+    /**
+     * @brief Run several operations as one transaction
+     * Calls made by work share the transaction; their own transactions become
+     * savepoints. Inside another transaction this is a savepoint as well, so a
+     * failed step only undoes its own changes.
+     * @param work The operations; return false to roll them back
+     * @return true if work succeeded and was committed, false otherwise
+     */
+    bool run_in_transaction(const function<bool()> &work);
+
+    /**
+     * @brief Run several reads against one consistent snapshot of the database
+     * In WAL mode concurrent writers do not block the reads and their commits
+     * are not seen until work returns.
+     * @param work The reads
+     * @return true if the snapshot was read without error
+     */
+    bool run_in_snapshot(const function<void()> &work);
+
+    /**
+     * @brief Check whether this connection was opened read-only
+     * @return true for read-only connections
+     */
+    bool is_read_only() const { return read_only; }
+
+    /**
+     * @brief Register a listener for committed task changes
+     * Changes are captured by SQLite's update hook and published once the
+     * outermost transaction commits; rolled back changes are never published.
+     * Listeners run on the committing thread and must not write through this
+     * connection. Safe to call from any thread.
+     * @param listener Called after every commit that changed tasks
+     * @return Subscription ID for unsubscribe_changes
+     */
+    int subscribe_changes(TaskChangeListener listener);
+
+    /**
+     * @brief Remove a change listener; safe to call from any thread
+     * @param subscription ID returned by subscribe_changes
+     */
+    void unsubscribe_changes(int subscription);
+
     /**
      * @brief Add a new task to the database
      * @param task The task to add
@@ -34,6 +185,14 @@ public:
      */
     int add_task(const Task &task);
 
+    /**
+     * @brief Add many tasks in a single transaction
+     * Either every task (with its links) is stored or none is.
+     * @param tasks The tasks to add; parent_id must refer to existing tasks
+     * @return IDs of the new tasks in input order, empty on failure
+     */
+    vector<int> add_tasks(const vector<Task> &tasks);
+
     /**
      * @brief Get all tasks from the database
      * @param include_completed Whether to include completed tasks
@@ -41,6 +200,107 @@ public:
      */
     vector<Task> get_all_tasks(bool include_completed = true);
 
+    /**
+     * @brief Get one page of tasks using keyset pagination
+     * Each page is an index range scan starting at the cursor, so deep pages cost
+     * the same as the first one.
+     * @param after Cursor from the previous page, or nullopt for the first page
+     * @param limit Maximum number of tasks in the page
+     * @param include_completed Whether to include completed tasks
+     * @return The tasks and the cursor for the next page
+     */
+    TaskPage get_tasks_page(const optional<TaskCursor> &after, int limit, bool include_completed = true);
+
+    /**
+     * @brief Stream all tasks in list order without loading them into memory at once
+     * Links and tags are loaded with each row.
+     * @param visitor Called for every task; return false to stop early
+     * @param include_completed Whether to include completed tasks
+     * @return true if the query ran without error (also when stopped early)
+     */
+    bool for_each_task(const function<bool(const Task &)> &visitor, bool include_completed = true);
+
+    /**
+     * @brief Get the tasks inserted, updated or deleted since a point in time
+     * Uses the updated_at index and the tombstones, so the cost follows the
+     * number of changes. Changes made in the millisecond of since are returned
+     * again by the next call; applying a change twice must be harmless.
+     * Tombstones are kept for 30 days; older marks need a full reload.
+     * @param since Milliseconds since the epoch, e.g. next_since of the previous delta or get_change_mark()
+     * @return The changes and the mark for the next call
+     */
+    TaskDelta get_tasks_changed_since(int64_t since);
+
+    /**
+     * @brief Get the time of the latest change in the database
+     * Read it before loading tasks to catch every later change with get_tasks_changed_since.
+     * @return Milliseconds since the epoch, 0 for an empty database, -1 on error
+     */
+    int64_t get_change_mark();
+
+    /**
+     * @brief Create the full-text index if it is missing and this build has FTS5
+     * A database migrated by a build without FTS5 has no index; this adds and
+     * fills it once FTS5 is available. Maintenance for the main instance, like
+     * prune_tombstones().
+     * @return true if search uses the full-text index
+     */
+    bool ensure_full_text_search();
+
+    /**
+     * @brief Delete tombstones older than the retention period
+     * Maintenance for the main instance; opening a database never writes to it.
+     */
+    void prune_tombstones();
+
+    /**
+     * @brief Search task descriptions and links
+     * Uses the FTS5 index when available: words match as prefixes, "quoted text"
+     * as a phrase, and results are ranked by relevance (bm25). Without FTS5,
+     * falls back to a case-insensitive substring match in list order.
+     * @param text Search text as typed by the user
+     * @param limit Maximum number of results
+     * @return Matching tasks with their links and tags, best match first
+     */
+    vector<Task> search_tasks(const string &text, int limit = 100);
+
+    /**
+     * @brief Attach the archive database as schema "archive", creating its tables if needed
+     * The archive holds completed tasks moved out of the tasks table with their
+     * links and tags, so the hot table only grows with current work. Queries
+     * on the tasks table are unaffected. Not available on read-only connections.
+     * @param archive_path The archive file (e.g., "tasks_archive.db")
+     * @return true if the archive is attached
+     */
+    bool attach_archive(const string &archive_path);
+
+    /**
+     * @brief Check whether an archive is attached
+     * @return true after a successful attach_archive
+     */
+    bool has_archive() const { return archive_attached; }
+
+    /**
+     * @brief Move long-completed task trees into the attached archive
+     * A top-level task is archived together with all of its subtasks once every
+     * one of them is completed and unchanged since the cutoff; a tree with an
+     * open or recently changed task stays. Archived tasks are published to the
+     * change feed as deletions.
+     * @param completed_before Cutoff in seconds since the epoch
+     * @return Number of archived tasks (0 without an archive), or -1 on error
+     */
+    int archive_completed_tasks(time_t completed_before);
+
+    /**
+     * @brief Search the archived tasks
+     * Same query syntax as search_tasks. Results are read-only: the tasks are
+     * no longer in the tasks table.
+     * @param text Search text as typed by the user
+     * @param limit Maximum number of results
+     * @return Matching archived tasks with their links and tags, best match first
+     */
+    vector<Task> search_archive(const string &text, int limit = 100);
+
     /**
      * @brief Get a task by ID
      * @param task_id The ID of the task
@@ -50,6 +310,7 @@ public:
 
     /**
      * @brief Update an existing task
+     * The task's tag assignments are replaced by task.tags.
      * @param task The task with updated information
      * @return true if successful, false otherwise
      */
@@ -62,6 +323,40 @@ public:
      */
     bool delete_task(int task_id);
 
+    /**
+     * @brief Apply the same changes to a set of tasks in one transaction
+     * @param task_ids IDs of the tasks to update
+     * @param patch The fields to change
+     * @param include_subtasks Also update all descendants of the given tasks
+     * @return Number of updated tasks, or -1 on error
+     */
+    int update_tasks(const vector<int> &task_ids, const TaskPatch &patch, bool include_subtasks = false);
+
+    /**
+     * @brief Apply the same changes to every task matching a filter in one transaction
+     * @param filter Tasks to update
+     * @param patch The fields to change
+     * @param include_subtasks Also update all descendants of the matching tasks
+     * @return Number of updated tasks, or -1 on error
+     */
+    int update_tasks_where(const TaskFilter &filter, const TaskPatch &patch, bool include_subtasks = false);
+
+    /**
+     * @brief Delete a set of tasks with their subtasks, links and tag assignments in one transaction
+     * @param task_ids IDs of the tasks to delete
+     * @param deleted_ids If given, receives the IDs of every deleted task (including subtasks)
+     * @return Number of deleted tasks, or -1 on error
+     */
+    int delete_tasks(const vector<int> &task_ids, vector<int> *deleted_ids = nullptr);
+
+    /**
+     * @brief Delete every task matching a filter with its subtasks, links and tag assignments
+     * @param filter Tasks to delete
+     * @param deleted_ids If given, receives the IDs of every deleted task (including subtasks)
+     * @return Number of deleted tasks, or -1 on error
+     */
+    int delete_tasks_where(const TaskFilter &filter, vector<int> *deleted_ids = nullptr);
+
     /**
      * @brief Get tasks by priority
      * @param priority The priority level (0=Low, 1=Medium, 2=High)
@@ -82,6 +377,12 @@ public:
      */
     vector<Task> get_subtasks(int parent_id);
 
+    /**
+     * @brief Get subtask counts for every parent task in one pass
+     * @return Map from parent task ID to its completed/total subtask counts
+     */
+    unordered_map<int, SubtaskCounts> get_subtask_counts();
+
     /**
      * @brief Add a link to a task
      * @param task_id The ID of the task
@@ -97,7 +398,296 @@ public:
      */
     vector<string> get_task_links(int task_id);
 
+    /**
+     * @brief Create a tag, or look up the existing tag with that name
+     * @param name The tag name
+     * @return The ID of the tag, or -1 on error
+     */
+    int add_tag(const string &name);
+
+    /**
+     * @brief Get all tags
+     * @return Vector of tags ordered by name
+     */
+    vector<Tag> get_all_tags();
+
+    /**
+     * @brief Rename a tag; the tasks carrying it are reported as updated
+     * @param tag_id The ID of the tag
+     * @param name The new name; must not be used by another tag
+     * @return true if the tag was renamed, false otherwise
+     */
+    bool rename_tag(int tag_id, const string &name);
+
+    /**
+     * @brief Delete a tag and remove it from every task
+     * @param tag_id The ID of the tag
+     * @return true if the tag was deleted, false otherwise
+     */
+    bool delete_tag(int tag_id);
+
+    /**
+     * @brief Replace the tags assigned to a task
+     * @param task_id The ID of the task
+     * @param tag_ids IDs of the tags the task should have
+     * @return true if successful, false otherwise
+     */
+    bool set_task_tags(int task_id, const vector<int> &tag_ids);
+
+    /**
+     * @brief Get all tag IDs assigned to a task
+     * @param task_id The ID of the task
+     * @return Vector of tag IDs in ascending order
+     */
+    vector<int> get_task_tags(int task_id);
+
+    /**
+     * @brief Get the number of queries served by an already compiled statement
+     * @return Statement cache hit count
+     */
+    long long get_statement_cache_hits() const { return statement_cache_hits; }
+
+    /**
+     * @brief Get the number of queries that had to be compiled
+     * @return Statement cache miss count
+     */
+    long long get_statement_cache_misses() const { return statement_cache_misses; }
+
+    /**
+     * @brief Get statement cache statistics
+     * @return String with statement cache hit/miss statistics
+     */
+    string get_statement_cache_stats() const;
+
 private:
+    /**
+     * @brief A compiled statement kept for reuse, keyed by its SQL text
+     */
+    struct CachedStatementEntry
+    {
+        unique_ptr<SQLite::Statement> statement;
+        bool in_use = false;
+    };
+
+    /**
+     * @brief Borrowed statement from the cache
+     * Resets the statement and clears its bindings when it goes out of scope,
+     * so no read transaction is left open between calls.
+     */
+    class StatementLease
+    {
+    public:
+        StatementLease(SQLite::Statement &statement, bool *in_use);
+        explicit StatementLease(unique_ptr<SQLite::Statement> owned_statement);
+        StatementLease(StatementLease &&other) noexcept;
+        StatementLease(const StatementLease &) = delete;
+        StatementLease &operator=(const StatementLease &) = delete;
+        StatementLease &operator=(StatementLease &&) = delete;
+        ~StatementLease();
+
+        SQLite::Statement &operator*() const { return *statement; }
+        SQLite::Statement *operator->() const { return statement; }
+
+    private:
+        SQLite::Statement *statement;
+        bool *in_use;
+        unique_ptr<SQLite::Statement> owned;
+    };
+
+    /**
+     * @brief Get a compiled statement for a query, preparing it on first use
+     * If the cached statement is already borrowed (nested use of the same
+     * query), a one-off statement is prepared instead.
+     * @param sql The SQL text of the query
+     * @return Lease on a reset statement with no bindings
+     */
+    StatementLease cached_statement(const string &sql);
+
+    /**
+     * @brief Write transaction that nests
+     * The outermost scope runs BEGIN IMMEDIATE/COMMIT; scopes opened inside it
+     * use a savepoint. Rolls back (to the savepoint) unless commit() was called.
+     */
+    class TransactionScope
+    {
+    public:
+        explicit TransactionScope(DatabaseManager &manager);
+        TransactionScope(const TransactionScope &) = delete;
+        TransactionScope &operator=(const TransactionScope &) = delete;
+        ~TransactionScope();
+
+        void commit();
+
+    private:
+        DatabaseManager &manager;
+        bool nested;
+        bool committed = false;
+        size_t change_mark; // Pending changes recorded before this scope
+    };
+
+    /**
+     * @brief sqlite3_update_hook callback: record a change to the tasks table
+     */
+    static void on_row_change(void *manager, int operation, const char *database, const char *table, long long row_id);
+
+    /**
+     * @brief sqlite3_commit_hook callback: the pending changes are being committed
+     * @return 0 to let the commit proceed
+     */
+    static int on_commit(void *manager);
+
+    /**
+     * @brief sqlite3_rollback_hook callback: drop the pending changes
+     */
+    static void on_rollback(void *manager);
+
+    /**
+     * @brief Record a change the update hook cannot see (links and tags live in other tables)
+     * @param type Kind of change
+     * @param task_id The changed task
+     */
+    void note_task_change(TaskChangeType type, int task_id);
+
+    /**
+     * @brief Hand the committed changes to the listeners, merged per task
+     */
+    void publish_changes();
+
+    /**
+     * @brief Apply the connection pragmas of a performance profile
+     * Invalid or rejected settings are reported and skipped.
+     * @param profile The settings to apply
+     */
+    void apply_profile(const SqliteProfile &profile);
+
+    /**
+     * @brief Read the current value of a pragma
+     * @param name Pragma name (e.g., "journal_mode")
+     * @return The value as text
+     */
+    string pragma_value(const string &name);
+
+    /**
+     * @brief Build a Task from the current row of a task query
+     * @param query Statement positioned on a row selecting the standard task columns
+     * @return The task (links and tags are not loaded)
+     */
+    static Task read_task_row(SQLite::Statement &query);
+
+    /**
+     * @brief Fill a task's links from column 9 of a streaming task query
+     * @param query Statement positioned on a row of a TASK_STREAM_SELECT query
+     * @param task The task to fill
+     */
+    static void read_links_column(SQLite::Statement &query, Task &task);
+
+    /**
+     * @brief Fill a task's tags from column 10 of a streaming task query
+     * @param query Statement positioned on a row of a TASK_STREAM_SELECT query
+     * @param task The task to fill
+     */
+    static void read_tags_column(SQLite::Statement &query, Task &task);
+
+    /**
+     * @brief Insert a task row with its links and tags
+     * Runs no transaction of its own and throws on failure.
+     * @param task The task to insert
+     * @return The ID of the inserted task
+     */
+    int insert_task_row(const Task &task);
+
+    /**
+     * @brief Assign tags to a task, skipping ones it already has
+     * Runs no transaction of its own and throws on failure.
+     */
+    void insert_task_tags(int task_id, const vector<int> &tag_ids);
+
+    /**
+     * @brief Remove a task's tags and assign the given ones
+     * Runs no transaction of its own and throws on failure.
+     */
+    void replace_task_tags(int task_id, const vector<int> &tag_ids);
+
+    /**
+     * @brief Fill the temporary bulk_task_ids table with the targets of a bulk operation
+     * Must run inside a transaction; the table is cleared first.
+     * @param task_ids Explicit IDs, used when filter is null
+     * @param filter Predicate selecting the IDs
+     * @param include_subtasks Add every descendant of the selected tasks
+     */
+    void select_bulk_ids(const vector<int> &task_ids, const TaskFilter *filter, bool include_subtasks);
+
+    /**
+     * @brief Update every task listed in bulk_task_ids
+     * @return Number of updated tasks
+     */
+    int update_bulk_ids(const TaskPatch &patch);
+
+    /**
+     * @brief Delete every task listed in bulk_task_ids with its links and tag assignments
+     * @param deleted_ids If given, receives the deleted IDs
+     * @return Number of deleted tasks
+     */
+    int delete_bulk_ids(vector<int> *deleted_ids);
+
+    /**
+     * @brief Build the SQL condition for a task filter
+     * @param filter The filter
+     * @param params Receives the values for the placeholders, in order
+     * @return Condition on the tasks table, empty if the filter matches everything
+     */
+    static string filter_condition(const TaskFilter &filter, vector<int64_t> &params);
+
+    /**
+     * @brief Build the batched link query for a task filter
+     * @param task_filter SQL condition on the tasks table (empty for all)
+     * @return SQL selecting task_id and link ordered by task and insertion
+     */
+    static string links_sql(const string &task_filter);
+
+    /**
+     * @brief Load links for a batch of tasks with a single query
+     * @param tasks Tasks to fill; links are appended in insertion order
+     * @param task_filter SQL condition on the tasks table matching the batch (empty for all)
+     * @param bind_filter Binds the parameters used in task_filter
+     */
+    void load_links(vector<Task> &tasks, const string &task_filter,
+                    const function<void(SQLite::Statement &)> &bind_filter = nullptr);
+
+    /**
+     * @brief Build the batched tag query for a task filter
+     * @param task_filter SQL condition on the tasks table (empty for all)
+     * @return SQL selecting task_id and tag_id ordered by task and tag
+     */
+    static string tags_sql(const string &task_filter);
+
+    /**
+     * @brief Load tag IDs for a batch of tasks with a single query
+     * @param tasks Tasks to fill; tag IDs are appended in ascending order
+     * @param task_filter SQL condition on the tasks table matching the batch (empty for all)
+     * @param bind_filter Binds the parameters used in task_filter
+     */
+    void load_tags(vector<Task> &tasks, const string &task_filter,
+                   const function<void(SQLite::Statement &)> &bind_filter = nullptr);
+
     unique_ptr<SQLite::Database> db;
     string db_path;
+    bool read_only;
+
+    optional<bool> full_text_search; // tasks_fts exists; checked on first search
+    bool archive_attached;           // Schema "archive" is attached (attach_archive)
+    bool archive_full_text_search;   // archive.tasks_fts exists
+    int transaction_depth;           // Open TransactionScopes
+
+    // Change feed: pending until commit, published after it
+    vector<TaskChange> pending_changes;
+    vector<TaskChange> committed_changes;
+    std::mutex listener_mutex;
+    vector<pair<int, TaskChangeListener>> change_listeners;
+    int next_subscription;
+
+    // Compiled statements; declared after db so they are finalized first
+    unordered_map<string, CachedStatementEntry> statement_cache;
+    long long statement_cache_hits;
+    long long statement_cache_misses;
 };
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include "DatabaseManager.hpp"
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <sqlite3.h>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::exception;
+using std::function;
+using std::string;
+using std::to_string;
+using std::vector;
+
+namespace fs = std::filesystem;
+
+// Statements run by the call under test; null while nothing is captured
+static vector<string> *captured_statements = nullptr;
+
+/**
+ * @brief Trace callback: record the SQL of every statement as it starts
+ */
+static int trace_statement(unsigned, void *, void *, void *sql_text)
+{
+    const char *sql = static_cast<const char *>(sql_text);
+    // Trigger programs are reported as "-- TRIGGER name"; their plans belong to the statement that fired them
+    if (captured_statements && sql && std::strncmp(sql, "--", 2) != 0)
+    {
+        captured_statements->push_back(sql);
+    }
+    return 0;
+}
+
+/**
+ * @brief Auto-extension entry point: trace each connection DatabaseManager opens
+ */
+static int install_trace(sqlite3 *db, char **, const sqlite3_api_routines *)
+{
+    sqlite3_trace_v2(db, SQLITE_TRACE_STMT, trace_statement, nullptr);
+    return SQLITE_OK;
+}
+
+static void remove_database(const string &path)
+{
+    for (const char *suffix : {"", "-wal", "-shm", "-journal"})
+    {
+        std::error_code ignored;
+        fs::remove(path + suffix, ignored);
+    }
+}
+
+/**
+ * @brief Fill the database with a small tree of tasks carrying links and tags
+ */
+static void populate(DatabaseManager &db)
+{
+    vector<int> tag_ids;
+    for (int t = 0; t < 4; ++t)
+    {
+        tag_ids.push_back(db.add_tag("tag" + to_string(t)));
+    }
+
+    time_t now = time(nullptr);
+    for (int n = 0; n < 200; ++n)
+    {
+        Task task;
+        task.description = "Test task " + to_string(n);
+        task.priority = n % 3;
+        if (n % 5 != 0)
+        {
+            task.due_date = now + (n % 7 - 3) * 86400;
+        }
+        task.is_completed = n % 4 == 0;
+        task.status = task.is_completed ? 4 : 0;
+        task.links.push_back("https://example.com/task/" + to_string(n));
+        task.tags.push_back(tag_ids[n % tag_ids.size()]);
+        int parent_id = db.add_task(task);
+
+        Task subtask = task;
+        subtask.description += " subtask";
+        subtask.parent_id = parent_id;
+        db.add_task(subtask);
+    }
+
+    // Leave a tombstone for the delta query
+    Task doomed;
+    doomed.description = "Deleted task";
+    db.delete_task(db.add_task(doomed));
+}
+
+/**
+ * @brief A database call and the index uses its plans must show
+ */
+struct PlanCase
+{
+    string name;
+    function<void(DatabaseManager &)> call;
+    vector<string> required; // Each must appear in the plan of one of the call's statements, in the order they run
+};
+
+/**
+ * @brief Run one call and check the plans of the statements it ran
+ * A call fails if a required index use is missing, or if the first
+ * statement using it also sorts in a temporary B-tree.
+ * @return One message per problem, empty if the plans are as expected
+ */
+static vector<string> check_plans(DatabaseManager &db, SQLite::Database &explain_db, const PlanCase &plan_case)
+{
+    vector<string> statements;
+    captured_statements = &statements;
+    plan_case.call(db);
+    captured_statements = nullptr;
+
+    vector<string> failures;
+    vector<string> plans;
+    for (const auto &sql : statements)
+    {
+        // Transaction control and pragmas have no query plan worth checking
+        bool control = false;
+        for (const char *keyword : {"BEGIN", "COMMIT", "ROLLBACK", "SAVEPOINT", "RELEASE", "PRAGMA"})
+        {
+            control = control || sql.compare(0, std::strlen(keyword), keyword) == 0;
+        }
+        if (control)
+        {
+            continue;
+        }
+
+        string plan;
+        try
+        {
+            SQLite::Statement query(explain_db, "EXPLAIN QUERY PLAN " + sql);
+            while (query.executeStep())
+            {
+                plan += (plan.empty() ? "" : "; ") + string(query.getColumn(3).getText());
+            }
+        }
+        catch (const exception &e)
+        {
+            failures.push_back(plan_case.name + ": " + e.what() + " in \"" + sql + "\"");
+            continue;
+        }
+        plans.push_back(plan);
+    }
+
+    for (const auto &required : plan_case.required)
+    {
+        bool found = false;
+        for (const auto &plan : plans)
+        {
+            if (plan.find(required) == string::npos)
+            {
+                continue;
+            }
+            found = true;
+            if (plan.find("USE TEMP B-TREE") != string::npos)
+            {
+                failures.push_back(plan_case.name + ": sorts in a temporary B-tree: \"" + plan + "\"");
+            }
+            break;
+        }
+        if (!found)
+        {
+            string all_plans;
+            for (const auto &plan : plans)
+            {
+                all_plans += (all_plans.empty() ? "" : " | ") + plan;
+            }
+            failures.push_back(plan_case.name + ": expected \"" + required + "\", got \"" + all_plans + "\"");
+        }
+    }
+
+    return failures;
+}
+
+/**
+ * @brief Verify that each task query is planned with its intended index
+ * Captures the SQL that DatabaseManager actually runs and explains it, so
+ * the check follows the queries as they change.
+ * @return true if every plan is as expected
+ */
+static bool test_query_plans(const string &path)
+{
+    DatabaseManager db(path);
+    db.initilize_database();
+    populate(db);
+
+    SQLite::Database explain_db(path, SQLite::OPEN_READONLY);
+
+    TaskPage first = db.get_tasks_page(std::nullopt, 10, true);
+    const Task &last = first.tasks.back();
+    TaskCursor dated{last.priority, last.due_date, last.id};
+    if (!dated.due_date.has_value())
+    {
+        dated.due_date = time(nullptr);
+    }
+    TaskCursor undated{last.priority, std::nullopt, last.id};
+    int tag_id = db.get_all_tags().front().id;
+
+    const vector<PlanCase> cases = {
+        {"get_all_tasks(all)", [](DatabaseManager &d)
+         { d.get_all_tasks(true); },
+         {"USING INDEX idx_tasks_priority_due", "USING INDEX idx_task_links_task_id", "USING COVERING INDEX sqlite_autoindex_task_tags_1"}},
+        {"get_all_tasks(active)", [](DatabaseManager &d)
+         { d.get_all_tasks(false); },
+         {"USING INDEX idx_tasks_active", "USING INDEX idx_task_links_task_id"}},
+        {"get_task_by_id", [](DatabaseManager &d)
+         { d.get_task_by_id(1); },
+         {"USING INTEGER PRIMARY KEY", "USING INDEX idx_task_links_task_id (task_id=?)",
+          "USING COVERING INDEX sqlite_autoindex_task_tags_1 (task_id=?)"}},
+        {"get_tasks_by_priority", [](DatabaseManager &d)
+         { d.get_tasks_by_priority(1); },
+         {"USING INDEX idx_tasks_priority_due (priority=?)"}},
+        {"get_overdue_tasks", [](DatabaseManager &d)
+         { d.get_overdue_tasks(); },
+         {"USING INDEX idx_tasks_overdue"}},
+        {"get_subtasks", [](DatabaseManager &d)
+         { d.get_subtasks(1); },
+         {"USING INDEX idx_tasks_parent (parent_id=?)"}},
+        {"get_subtask_counts", [](DatabaseManager &d)
+         { d.get_subtask_counts(); },
+         {"USING COVERING INDEX idx_tasks_parent"}},
+        {"get_tasks_changed_since", [](DatabaseManager &d)
+         { d.get_tasks_changed_since(1); },
+         {"USING INDEX idx_tasks_updated_at (updated_at>?)", "USING COVERING INDEX idx_task_tombstones_deleted_at (deleted_at>?)"}},
+        {"get_tasks_page(first)", [](DatabaseManager &d)
+         { d.get_tasks_page(std::nullopt, 10, true); },
+         {"USING INDEX idx_tasks_priority_due"}},
+        {"get_tasks_page(due date)", [&](DatabaseManager &d)
+         { d.get_tasks_page(dated, 1000, true); },
+         {"USING INDEX idx_tasks_priority_due (priority=? AND due_date=? AND rowid>?)",
+          "USING INDEX idx_tasks_priority_due (priority=? AND due_date>?)", "USING INDEX idx_tasks_priority_due (priority<?)"}},
+        {"get_tasks_page(no due date)", [&](DatabaseManager &d)
+         { d.get_tasks_page(undated, 1000, true); },
+         {"USING INDEX idx_tasks_priority_due (priority=? AND due_date>?)"}},
+        {"get_tasks_page(active)", [&](DatabaseManager &d)
+         { d.get_tasks_page(dated, 1000, false); },
+         {"USING INDEX idx_tasks_active (priority=? AND due_date=? AND rowid>?)"}},
+        {"for_each_task", [](DatabaseManager &d)
+         { d.for_each_task([](const Task &)
+                           { return true; }); },
+         {"USING INDEX idx_tasks_priority_due"}},
+        {"delete_tag", [&](DatabaseManager &d)
+         { d.delete_tag(tag_id); },
+         {"USING INDEX idx_task_tags_tag_id (tag_id=?)", "INDEX idx_task_tags_tag_id (tag_id=?)"}},
+    };
+
+    bool ok = true;
+    for (const auto &plan_case : cases)
+    {
+        vector<string> failures = check_plans(db, explain_db, plan_case);
+        for (const auto &failure : failures)
+        {
+            cout << "PLAN FAIL " << failure << "\n";
+        }
+        ok = ok && failures.empty();
+    }
+    cout << (ok ? "query plans OK" : "query plans FAILED") << endl;
+    return ok;
+}
+
+int main()
+{
+    sqlite3_auto_extension(reinterpret_cast<void (*)(void)>(install_trace));
+
+    string path = (fs::temp_directory_path() / "teminder_tests.db").string();
+    remove_database(path);
+
+    bool ok;
+    try
+    {
+        ok = test_query_plans(path);
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error: " << e.what() << endl;
+        ok = false;
+    }
+
+    remove_database(path);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+#include "DatabaseWatcher.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using std::cerr;
+using std::endl;
+using std::exception;
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+namespace fs = std::filesystem;
+
+// Time for the remaining writes of a commit to land before data_version is read
+static const std::chrono::milliseconds EVENT_SETTLE_TIME(20);
+
+DatabaseWatcher::DatabaseWatcher(const string &db_path, VersionSource data_version, function<void()> on_change,
+                                 std::chrono::milliseconds interval)
+    : db_path(db_path), db_name(fs::path(db_path).filename().string()), data_version(std::move(data_version)),
+      on_change(std::move(on_change)), interval(interval), inotify_fd(-1), wake_fd(-1), stopping(false), change_count(0)
+{
+    open_file_events();
+    worker = std::thread([this]
+                         { run(); });
+}
+
+DatabaseWatcher::~DatabaseWatcher()
+{
+    {
+        lock_guard<mutex> lock(watcher_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+#ifdef __linux__
+    if (wake_fd >= 0)
+    {
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof(one)) < 0)
+        {
+            cerr << "Error waking database watcher" << endl;
+        }
+    }
+#endif
+
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+    close_file_events();
+}
+
+long long DatabaseWatcher::get_change_count() const
+{
+    lock_guard<mutex> lock(watcher_mutex);
+    return change_count;
+}
+
+void DatabaseWatcher::run()
+{
+    long long last_version = data_version();
+
+    while (wait_for_event(interval))
+    {
+        long long version = data_version();
+        if (version < 0 || version == last_version)
+        {
+            continue; // Our own commit, a checkpoint, or nothing at all
+        }
+
+        bool first_read = last_version < 0;
+        last_version = version;
+        if (first_read)
+        {
+            continue;
+        }
+
+        {
+            lock_guard<mutex> lock(watcher_mutex);
+            change_count++;
+        }
+
+        try
+        {
+            on_change();
+        }
+        catch (const exception &e)
+        {
+            cerr << "Error handling database change: " << e.what() << endl;
+        }
+    }
+}
+
+bool DatabaseWatcher::wait_for_event(std::chrono::milliseconds timeout)
+{
+#ifdef __linux__
+    if (inotify_fd >= 0)
+    {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (true)
+        {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            pollfd fds[2] = {{inotify_fd, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+            int ready = poll(fds, 2, static_cast<int>(std::max<long long>(0, remaining.count())));
+            if (ready < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (fds[1].revents != 0)
+            {
+                return false;
+            }
+            if (ready <= 0)
+            {
+                return true; // Timer: check anyway
+            }
+
+            // Only the database and its WAL matter, not other files in the directory
+            bool relevant = false;
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char *p = buffer; p < buffer + length;)
+                {
+                    auto *event = reinterpret_cast<inotify_event *>(p);
+                    string name = event->len > 0 ? event->name : "";
+                    relevant = relevant || name == db_name || name == db_name + "-wal";
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+            if (!relevant)
+            {
+                continue;
+            }
+
+            // A commit touches the files several times; check once they are done
+            pollfd wake_only = {wake_fd, POLLIN, 0};
+            if (poll(&wake_only, 1, static_cast<int>(EVENT_SETTLE_TIME.count())) > 0)
+            {
+                return false;
+            }
+            while (read(inotify_fd, buffer, sizeof(buffer)) > 0)
+            {
+                // Drop the events of the same commit
+            }
+            return true;
+        }
+    }
+#endif
+
+    unique_lock<mutex> lock(watcher_mutex);
+    return !wake.wait_for(lock, timeout, [&]
+                          { return stopping; });
+}
+
+void DatabaseWatcher::open_file_events()
+{
+#ifdef __linux__
+    fs::path directory = fs::absolute(db_path).parent_path();
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    // The WAL is created and removed as connections come and go, so the directory is watched
+    if (inotify_fd < 0 || wake_fd < 0 ||
+        inotify_add_watch(inotify_fd, directory.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO) < 0)
+    {
+        cerr << "Warning: Cannot watch " << directory.string() << " for changes; checking every "
+             << interval.count() << " ms instead." << endl;
+        close_file_events();
+    }
+#endif
+}
+
+void DatabaseWatcher::close_file_events()
+{
+#ifdef __linux__
+    if (inotify_fd >= 0)
+    {
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+    if (wake_fd >= 0)
+    {
+        close(wake_fd);
+        wake_fd = -1;
+    }
+#endif
+}
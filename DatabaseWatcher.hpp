@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using std::function;
+using std::string;
+
+/**
+ * @brief Notices commits made to the database file by other processes
+ * A background thread waits for the database or its WAL to be modified
+ * (inotify on Linux, a timer elsewhere) and then compares PRAGMA data_version,
+ * which only changes for commits made through other connections. The timer
+ * also runs on Linux as a fallback for file systems without inotify support.
+ */
+class DatabaseWatcher
+{
+public:
+    /**
+     * @brief Reads PRAGMA data_version on a connection that sees foreign commits, -1 on error
+     */
+    using VersionSource = function<long long()>;
+
+    /**
+     * @brief Start watching
+     * @param db_path The database file
+     * @param data_version Reads the data version; called on the watcher thread
+     * @param on_change Called on the watcher thread after foreign commits were detected
+     * @param interval Time between checks when no file event arrives
+     */
+    DatabaseWatcher(const string &db_path, VersionSource data_version, function<void()> on_change,
+                    std::chrono::milliseconds interval = std::chrono::milliseconds(2000));
+
+    /**
+     * @brief Stop the watcher thread
+     */
+    ~DatabaseWatcher();
+
+    DatabaseWatcher(const DatabaseWatcher &) = delete;
+    DatabaseWatcher &operator=(const DatabaseWatcher &) = delete;
+
+    /**
+     * @brief Check whether file events are used (otherwise only the timer runs)
+     * @return true if inotify watches the database directory
+     */
+    bool uses_file_events() const { return inotify_fd >= 0; }
+
+    /**
+     * @brief Get the number of foreign changes reported so far
+     * @return Number of on_change calls
+     */
+    long long get_change_count() const;
+
+private:
+    /**
+     * @brief Watcher thread: wait for file events or the timer, then compare versions
+     */
+    void run();
+
+    /**
+     * @brief Wait for a modification of the database or WAL file
+     * @param timeout Longest time to wait
+     * @return false if the watcher is stopping
+     */
+    bool wait_for_event(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Open the inotify watch on the database directory (Linux only)
+     */
+    void open_file_events();
+
+    /**
+     * @brief Close the inotify and wake-up descriptors
+     */
+    void close_file_events();
+
+    string db_path;
+    string db_name; // File name of the database within its directory
+    VersionSource data_version;
+    function<void()> on_change;
+    std::chrono::milliseconds interval;
+
+    int inotify_fd; // -1 without file events
+    int wake_fd;    // eventfd that interrupts the wait on shutdown
+
+    mutable std::mutex watcher_mutex;
+    std::condition_variable wake; // Shutdown requested (timer-only mode)
+    bool stopping;
+    long long change_count;
+
+    std::thread worker; // Started last, after every member it uses
+};
@@ -0,0 +1,102 @@
+#include "ReadConnectionPool.hpp"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+using std::cerr;
+using std::endl;
+using std::exception;
+using std::lock_guard;
+using std::make_unique;
+using std::mutex;
+using std::unique_lock;
+
+ReadConnectionPool::ReadConnectionPool(const string &db_path, const SqliteProfile &profile, size_t max_connections)
+    : db_path(db_path), profile(profile), max_connections(max_connections), open_connections(0)
+{
+    if (this->max_connections == 0)
+    {
+        unsigned threads = std::thread::hardware_concurrency();
+        this->max_connections = std::max(1u, std::min(8u, threads));
+    }
+}
+
+ReadConnectionPool::Lease ReadConnectionPool::acquire()
+{
+    unique_lock<mutex> lock(pool_mutex);
+    available.wait(lock, [&]
+                   { return !idle.empty() || open_connections < max_connections; });
+
+    if (!idle.empty())
+    {
+        unique_ptr<DatabaseManager> connection = std::move(idle.back());
+        idle.pop_back();
+        return Lease(*this, std::move(connection));
+    }
+
+    // Open outside the lock; the slot is reserved so the limit holds
+    open_connections++;
+    lock.unlock();
+
+    try
+    {
+        return Lease(*this, make_unique<DatabaseManager>(db_path, profile, true));
+    }
+    catch (...)
+    {
+        lock.lock();
+        open_connections--;
+        lock.unlock();
+        available.notify_one();
+        throw;
+    }
+}
+
+bool ReadConnectionPool::read(const function<void(DatabaseManager &)> &work)
+{
+    try
+    {
+        Lease connection = acquire();
+        return connection->run_in_snapshot([&]()
+                                           { work(*connection); });
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error reading from connection pool: " << e.what() << endl;
+        return false;
+    }
+}
+
+size_t ReadConnectionPool::size() const
+{
+    lock_guard<mutex> lock(pool_mutex);
+    return open_connections;
+}
+
+void ReadConnectionPool::release(unique_ptr<DatabaseManager> connection)
+{
+    {
+        lock_guard<mutex> lock(pool_mutex);
+        idle.push_back(std::move(connection));
+    }
+    available.notify_one();
+}
+
+ReadConnectionPool::Lease::Lease(ReadConnectionPool &pool, unique_ptr<DatabaseManager> connection)
+    : pool(&pool), connection(std::move(connection))
+{
+}
+
+ReadConnectionPool::Lease::Lease(Lease &&other) noexcept
+    : pool(other.pool), connection(std::move(other.connection))
+{
+    other.pool = nullptr;
+}
+
+ReadConnectionPool::Lease::~Lease()
+{
+    if (pool != nullptr && connection)
+    {
+        pool->release(std::move(connection));
+    }
+}
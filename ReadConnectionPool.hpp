@@ -0,0 +1,97 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "DatabaseManager.hpp"
+#include "SqliteProfile.hpp"
+
+using std::function;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * @brief Thread-safe pool of read-only database connections
+ * Background work borrows a connection instead of sharing the UI's. In WAL
+ * mode each reader sees its own snapshot, so readers run in parallel with
+ * each other and with the writer.
+ */
+class ReadConnectionPool
+{
+public:
+    /**
+     * @brief Borrowed connection; returned to the pool when the lease is destroyed
+     * A lease must be used by one thread at a time.
+     */
+    class Lease
+    {
+    public:
+        Lease(ReadConnectionPool &pool, unique_ptr<DatabaseManager> connection);
+        Lease(Lease &&other) noexcept;
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        Lease &operator=(Lease &&) = delete;
+        ~Lease();
+
+        DatabaseManager &operator*() const { return *connection; }
+        DatabaseManager *operator->() const { return connection.get(); }
+
+    private:
+        ReadConnectionPool *pool;
+        unique_ptr<DatabaseManager> connection;
+    };
+
+    /**
+     * @brief Create an empty pool; connections are opened on first use
+     * The database must already exist with an initialized schema.
+     * @param db_path The database file
+     * @param profile Cache and memory settings for each connection
+     * @param max_connections Upper limit of open connections (0 = one per hardware thread, at most 8)
+     */
+    ReadConnectionPool(const string &db_path, const SqliteProfile &profile = SqliteProfile(), size_t max_connections = 0);
+
+    /**
+     * @brief Borrow a connection, waiting while all of them are in use
+     * @return Lease on a read-only connection
+     * @throws SQLite::Exception if a new connection cannot be opened
+     */
+    Lease acquire();
+
+    /**
+     * @brief Run reads on a pooled connection against one snapshot
+     * @param work The reads; called on the calling thread
+     * @return true if the reads ran without error
+     */
+    bool read(const function<void(DatabaseManager &)> &work);
+
+    /**
+     * @brief Get the number of open connections
+     * @return Open connections, borrowed or idle
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the maximum number of connections
+     * @return Connection limit
+     */
+    size_t capacity() const { return max_connections; }
+
+private:
+    /**
+     * @brief Put a connection back and wake one waiting thread
+     */
+    void release(unique_ptr<DatabaseManager> connection);
+
+    string db_path;
+    SqliteProfile profile;
+    size_t max_connections;
+
+    mutable std::mutex pool_mutex;
+    std::condition_variable available;        // A connection was returned
+    vector<unique_ptr<DatabaseManager>> idle; // Open connections not borrowed
+    size_t open_connections;
+};
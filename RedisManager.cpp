@@ -7,6 +7,8 @@ using nlohmann::json;
 using std::cerr;
 using std::cout;
 using std::endl;
+using std::lock_guard;
+using std::mutex;
 using std::nullopt;
 using std::stringstream;
 using std::to_string;
@@ -28,6 +30,7 @@ RedisManager::~RedisManager()
 
 bool RedisManager::connect()
 {
+    lock_guard<mutex> lock(context_mutex);
     if (connected)
     {
         return true;
@@ -144,6 +147,7 @@ optional<Task> RedisManager::deserialize_task(const string &json_str)
 
 bool RedisManager::cache_task(const Task &task, int ttl)
 {
+    lock_guard<mutex> lock(context_mutex);
     if (!connected)
     {
         return false;
@@ -179,6 +183,7 @@ bool RedisManager::cache_task(const Task &task, int ttl)
 
 optional<Task> RedisManager::get_cached_task(int task_id)
 {
+    lock_guard<mutex> lock(context_mutex);
     if (!connected)
     {
         cache_misses++;
@@ -211,6 +216,7 @@ optional<Task> RedisManager::get_cached_task(int task_id)
 
 bool RedisManager::invalidate_task(int task_id)
 {
+    lock_guard<mutex> lock(context_mutex);
     if (!connected)
     {
         return false;
@@ -231,6 +237,48 @@ bool RedisManager::invalidate_task(int task_id)
     return success;
 }
 
+int RedisManager::invalidate_changes(const vector<TaskChange> &changes)
+{
+    vector<string> args = {"DEL"};
+    for (const auto &change : changes)
+    {
+        if (change.type != TaskChangeType::Inserted)
+        {
+            args.push_back(get_task_key(change.task_id));
+        }
+    }
+    if (args.size() == 1)
+    {
+        return 0;
+    }
+
+    lock_guard<mutex> lock(context_mutex);
+    if (!connected)
+    {
+        return -1;
+    }
+
+    vector<const char *> argv;
+    vector<size_t> argv_lengths;
+    for (const auto &arg : args)
+    {
+        argv.push_back(arg.c_str());
+        argv_lengths.push_back(arg.size());
+    }
+
+    redisReply *reply = (redisReply *)redisCommandArgv(context, static_cast<int>(argv.size()), argv.data(), argv_lengths.data());
+
+    if (reply == nullptr)
+    {
+        cerr << "Redis DEL command failed" << endl;
+        return -1;
+    }
+
+    int removed = reply->type == REDIS_REPLY_INTEGER ? static_cast<int>(reply->integer) : -1;
+    freeReplyObject(reply);
+    return removed;
+}
+
 int RedisManager::cache_tasks(const vector<Task> &tasks, int ttl)
 {
     int count = 0;
@@ -246,6 +294,7 @@ int RedisManager::cache_tasks(const vector<Task> &tasks, int ttl)
 
 bool RedisManager::clear_all_tasks()
 {
+    lock_guard<mutex> lock(context_mutex);
     if (!connected)
     {
         return false;
@@ -276,6 +325,7 @@ bool RedisManager::clear_all_tasks()
 
 string RedisManager::get_stats() const
 {
+    lock_guard<mutex> lock(context_mutex);
     stringstream ss;
     int total = cache_hits + cache_misses;
     float hit_rate = total > 0 ? (float)cache_hits / total * 100.0f : 0.0f;
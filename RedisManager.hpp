@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <optional>
@@ -12,7 +14,8 @@ using std::vector;
 
 /**
  * @brief Manages Redis caching for tasks
- * Provides high-performance in-memory caching for frequently accessed tasks
+ * Provides high-performance in-memory caching for frequently accessed tasks.
+ * Calls may come from several threads; they share one connection in turn.
  */
 class RedisManager
 {
@@ -63,6 +66,15 @@ public:
      */
     bool invalidate_task(int task_id);
 
+    /**
+     * @brief Drop the cached copies of changed tasks with a single DEL
+     * Meant as a DatabaseManager change listener; inserted tasks are skipped
+     * since they cannot be cached yet.
+     * @param changes Committed task changes
+     * @return Number of keys removed, or -1 on error
+     */
+    int invalidate_changes(const vector<TaskChange> &changes);
+
     /**
      * @brief Cache multiple tasks
      * @param tasks Vector of tasks to cache
@@ -106,9 +118,10 @@ private:
     string get_task_key(int task_id) const;
 
     redisContext *context;
+    mutable std::mutex context_mutex; // hiredis contexts are not thread-safe
     string host;
     int port;
-    bool connected;
+    std::atomic<bool> connected; // Written under context_mutex, read without it by is_connected()
 
     // Statistics
     mutable int cache_hits;
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+using std::string;
+
+/**
+ * @brief SQLite connection settings applied when the database is opened
+ * Defaults favour a single local user: WAL so readers never block the writer,
+ * and synchronous=NORMAL, which is durable across application crashes in WAL mode.
+ */
+struct SqliteProfile
+{
+    string journal_mode = "WAL";   // DELETE, TRUNCATE, PERSIST, MEMORY, WAL or OFF
+    string synchronous = "NORMAL"; // OFF, NORMAL, FULL or EXTRA
+    long long mmap_size = 268435456; // Bytes of the file to memory-map (0 disables)
+    int cache_size = -65536;       // Page cache size; negative values are KiB, positive values pages
+    string temp_store = "MEMORY";  // DEFAULT, FILE or MEMORY
+    int busy_timeout_ms = 5000;    // Wait this long for a lock held by another connection
+};
@@ -0,0 +1,126 @@
+#include "TagIndex.hpp"
+#include <algorithm>
+
+void TagIndex::build(const vector<Task> &tasks)
+{
+    clear();
+    for (const auto &task : tasks)
+    {
+        add_task(task);
+    }
+}
+
+void TagIndex::clear()
+{
+    bitmaps.clear();
+}
+
+void TagIndex::add_task(const Task &task)
+{
+    for (int tag_id : task.tags)
+    {
+        set_bit(bitmaps[tag_id], task.id);
+    }
+}
+
+void TagIndex::remove_task(const Task &task)
+{
+    for (int tag_id : task.tags)
+    {
+        auto it = bitmaps.find(tag_id);
+        if (it != bitmaps.end())
+        {
+            clear_bit(it->second, task.id);
+        }
+    }
+}
+
+TagIndex::Bitmap TagIndex::match_all(const vector<int> &tag_ids) const
+{
+    Bitmap result;
+
+    for (size_t i = 0; i < tag_ids.size(); ++i)
+    {
+        auto it = bitmaps.find(tag_ids[i]);
+        if (it == bitmaps.end())
+        {
+            return {};
+        }
+
+        if (i == 0)
+        {
+            result = it->second;
+            continue;
+        }
+
+        // Bits past the end of the shorter bitmap are zero
+        const Bitmap &other = it->second;
+        result.resize(std::min(result.size(), other.size()));
+        for (size_t word = 0; word < result.size(); ++word)
+        {
+            result[word] &= other[word];
+        }
+    }
+
+    return result;
+}
+
+bool TagIndex::contains(const Bitmap &bitmap, int task_id)
+{
+    if (task_id < 0)
+    {
+        return false;
+    }
+
+    size_t word = static_cast<size_t>(task_id) / 64;
+    return word < bitmap.size() && (bitmap[word] >> (task_id % 64) & 1) != 0;
+}
+
+size_t TagIndex::count(int tag_id) const
+{
+    auto it = bitmaps.find(tag_id);
+    if (it == bitmaps.end())
+    {
+        return 0;
+    }
+
+    size_t total = 0;
+    for (uint64_t word : it->second)
+    {
+        while (word != 0)
+        {
+            word &= word - 1;
+            ++total;
+        }
+    }
+    return total;
+}
+
+void TagIndex::set_bit(Bitmap &bitmap, int task_id)
+{
+    if (task_id < 0)
+    {
+        return;
+    }
+
+    size_t word = static_cast<size_t>(task_id) / 64;
+    if (word >= bitmap.size())
+    {
+        bitmap.resize(word + 1, 0);
+    }
+    bitmap[word] |= uint64_t{1} << (task_id % 64);
+}
+
+void TagIndex::clear_bit(Bitmap &bitmap, int task_id)
+{
+    if (task_id < 0)
+    {
+        return;
+    }
+
+    size_t word = static_cast<size_t>(task_id) / 64;
+    if (word < bitmap.size())
+    {
+        bitmap[word] &= ~(uint64_t{1} << (task_id % 64));
+    }
+}
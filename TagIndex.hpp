@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Task.hpp"
+
+using std::unordered_map;
+using std::vector;
+
+/**
+ * @brief In-memory tag -> task ID index over the loaded task list
+ * Each tag owns a bitmap with one bit per task ID, so filtering by several
+ * tags is a word-wise AND and needs no database query.
+ */
+class TagIndex
+{
+public:
+    using Bitmap = vector<uint64_t>;
+
+    /**
+     * @brief Rebuild the index from a task list
+     * @param tasks The tasks to index
+     */
+    void build(const vector<Task> &tasks);
+
+    /**
+     * @brief Remove every entry
+     */
+    void clear();
+
+    /**
+     * @brief Index the tags of one task
+     * @param task The task to add
+     */
+    void add_task(const Task &task);
+
+    /**
+     * @brief Remove one task from the bitmaps of its tags
+     * @param task The task as it was indexed
+     */
+    void remove_task(const Task &task);
+
+    /**
+     * @brief Get the tasks that have every given tag
+     * @param tag_ids Tags to match; an unknown tag matches nothing
+     * @return Bitmap of matching task IDs (empty if tag_ids is empty)
+     */
+    Bitmap match_all(const vector<int> &tag_ids) const;
+
+    /**
+     * @brief Check whether a task ID is set in a bitmap
+     * @param bitmap Result of match_all
+     * @param task_id The task ID
+     * @return true if the task is in the bitmap
+     */
+    static bool contains(const Bitmap &bitmap, int task_id);
+
+    /**
+     * @brief Get the number of indexed tasks with a tag
+     * @param tag_id The tag ID
+     * @return Number of tasks
+     */
+    size_t count(int tag_id) const;
+
+private:
+    static void set_bit(Bitmap &bitmap, int task_id);
+    static void clear_bit(Bitmap &bitmap, int task_id);
+
+    unordered_map<int, Bitmap> bitmaps; // Tag ID -> task ID bits
+};
@@ -118,3 +118,22 @@ struct Task
         }
     }
 };
+
+/**
+ * @brief Kind of change made to a task row
+ */
+enum class TaskChangeType
+{
+    Inserted,
+    Updated, // Row, links or tags changed
+    Deleted
+};
+
+/**
+ * @brief One committed change to a task, as published by DatabaseManager
+ */
+struct TaskChange
+{
+    TaskChangeType type;
+    int task_id;
+};
@@ -3,7 +3,10 @@
 #include <ftxui/component/component.hpp>
 #include <ftxui/component/screen_interactive.hpp>
 #include <ftxui/dom/elements.hpp>
+#include <algorithm>
+#include <cctype>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <thread>
 #include <chrono>
@@ -20,56 +23,647 @@ using std::endl;
 using std::stringstream;
 using std::to_string;
 
-TaskListView::TaskListView(DatabaseManager &db_manager, AIAssistant &ai_assistant, RedisManager *redis_manager)
-    : db(db_manager), ai(ai_assistant), redis(redis_manager),
+/**
+ * @brief Check whether two reads of a task show the same content
+ */
+static bool same_task(const Task &a, const Task &b)
+{
+    return a.id == b.id && a.description == b.description && a.is_completed == b.is_completed &&
+           a.priority == b.priority && a.created_at == b.created_at && a.due_date == b.due_date &&
+           a.links == b.links && a.tags == b.tags && a.parent_id == b.parent_id &&
+           a.progress == b.progress && a.status == b.status;
+}
+
+TaskListView::TaskListView(DatabaseManager &db_manager, AIAssistant &ai_assistant, WriteBehindQueue &write_queue,
+                           RedisManager *redis_manager, ReadConnectionPool *read_pool, DatabaseBackup *backup)
+    : db(db_manager), ai(ai_assistant), write_queue(write_queue), redis(redis_manager), read_pool(read_pool), backup(backup),
+      change_subscription(-1), change_mark(0),
       screen(ScreenInteractive::Fullscreen()),
       selected_index(0), show_completed(true),
       status_message("Welcome to Teminder!"),
       current_view("list"),
       show_progress(false), progress_value(0), progress_message(""),
+      details_task_id(-1), details_text(""),
+      scroll_offset(0), completed_task_count(0),
+      archived_results_start(0), search_archive(false), search_selected(0), row_generation(0),
+      ai_busy(false), ai_job_id(0),
       input_description(""), input_priority(1), input_due_date(""), input_link(""), input_progress(0), input_status(0),
-      current_input_field(0)
+      input_tags(""), current_input_field(0)
 {
     refresh_tasks();
+
+    // Commits arrive on the writing thread; apply them on the UI thread
+    DatabaseManager::TaskChangeListener listener = [this](const vector<TaskChange> &changes)
+    {
+        screen.Post([this, changes]
+                    { apply_task_changes(changes); });
+        screen.PostEvent(Event::Custom);
+    };
+    change_subscription = write_queue.subscribe_changes(listener);
+}
+
+TaskListView::~TaskListView()
+{
+    stop_ai_job();
+
+    // A backup cut short leaves no partial file behind
+    if (backup)
+    {
+        backup->cancel();
+    }
+
+    write_queue.unsubscribe_changes(change_subscription);
+
+    // No write callback may outlive the view
+    write_queue.flush();
 }
 
 void TaskListView::refresh_tasks()
 {
-    vector<Task> all_tasks = db.get_all_tasks(show_completed);
+    // Queued writes are not waited for: each reaches the list through the change
+    // feed once committed, so the UI thread never blocks on the writer
+    vector<Task> all_tasks;
+    vector<Tag> all_tags;
+    db.run_in_snapshot([&]()
+                       {
+        change_mark = std::max<int64_t>(0, db.get_change_mark());
+        delta_rows.clear();
+        delta_deleted_ids.clear();
+        all_tasks = db.get_all_tasks(show_completed);
+        subtask_counts = db.get_subtask_counts();
+        all_tags = db.get_all_tags(); });
+
+    tag_names.clear();
+    for (const auto &tag : all_tags)
+    {
+        tag_names[tag.id] = tag.name;
+    }
 
-    // Reorder tasks: parent tasks first, then their subtasks below them
+    details_task_id = -1;
+    row_cache.clear();
+    row_versions.clear();
+
+    // Index children by parent, keeping the query order among siblings
+    unordered_map<int, vector<size_t>> children;
+    vector<size_t> roots;
+    for (size_t i = 0; i < all_tasks.size(); ++i)
+    {
+        if (all_tasks[i].is_subtask())
+        {
+            children[all_tasks[i].parent_id.value()].push_back(i);
+        }
+        else
+        {
+            roots.push_back(i);
+        }
+    }
+
+    // Reorder tasks: each task is followed by its subtasks, at any nesting depth.
+    // Depth-first walk with an explicit stack; every task is visited once.
     tasks.clear();
-    for (const auto &task : all_tasks)
+    task_depths.clear();
+    tasks.reserve(all_tasks.size());
+    task_depths.reserve(all_tasks.size());
+
+    vector<std::pair<size_t, int>> pending; // (index in all_tasks, depth)
+    for (auto it = roots.rbegin(); it != roots.rend(); ++it)
     {
-        if (!task.is_subtask())
+        pending.emplace_back(*it, 0);
+    }
+
+    while (!pending.empty())
+    {
+        auto [index, depth] = pending.back();
+        pending.pop_back();
+
+        auto child_list = children.find(all_tasks[index].id);
+        if (child_list != children.end())
         {
-            // Add parent task
-            tasks.push_back(task);
-            // Add its subtasks right after
-            for (const auto &potential_subtask : all_tasks)
+            for (auto it = child_list->second.rbegin(); it != child_list->second.rend(); ++it)
             {
-                if (potential_subtask.parent_id.has_value() && potential_subtask.parent_id.value() == task.id)
-                {
-                    tasks.push_back(potential_subtask);
-                }
+                pending.emplace_back(*it, depth + 1);
             }
         }
+
+        tasks.push_back(std::move(all_tasks[index]));
+        task_depths.push_back(depth);
     }
 
+    // Drop marks on tasks that are no longer listed
+    if (!marked_task_ids.empty())
+    {
+        unordered_set<int> listed;
+        for (const auto &task : tasks)
+        {
+            if (marked_task_ids.count(task.id))
+            {
+                listed.insert(task.id);
+            }
+        }
+        marked_task_ids.swap(listed);
+    }
+
+    tag_index.build(tasks);
+    unfiltered_tasks.clear();
+    unfiltered_depths.clear();
+    filter_loaded_tasks();
+    rebuild_task_positions();
+
     if (selected_index >= static_cast<int>(tasks.size()))
     {
         selected_index = tasks.size() > 0 ? tasks.size() - 1 : 0;
     }
+    recount_completed();
 }
 
-string TaskListView::format_task(const Task &task, bool is_selected) const
+void TaskListView::filter_loaded_tasks()
 {
-    stringstream ss;
+    if (tag_filter.empty())
+    {
+        return;
+    }
+
+    TagIndex::Bitmap matches = tag_index.match_all(tag_filter);
+    unfiltered_tasks = std::move(tasks);
+    unfiltered_depths = std::move(task_depths);
+    tasks.clear();
+    task_depths.clear();
+
+    // Matches are listed flat: their parents may be filtered out
+    for (const auto &task : unfiltered_tasks)
+    {
+        if (TagIndex::contains(matches, task.id))
+        {
+            tasks.push_back(task);
+            task_depths.push_back(0);
+        }
+    }
+}
+
+void TaskListView::set_tag_filter(const vector<int> &tag_ids)
+{
+    int selected_id = selected_index < static_cast<int>(tasks.size()) ? tasks[selected_index].id : -1;
+
+    // Put the full list back before applying the new filter
+    if (!tag_filter.empty())
+    {
+        tasks = std::move(unfiltered_tasks);
+        task_depths = std::move(unfiltered_depths);
+        unfiltered_tasks.clear();
+        unfiltered_depths.clear();
+    }
+
+    tag_filter = tag_ids;
+    filter_loaded_tasks();
+    rebuild_task_positions();
+    details_task_id = -1;
+
+    // Keep the selected task selected if it is still shown
+    size_t index = find_task_index(selected_id);
+    selected_index = index < tasks.size() ? static_cast<int>(index) : 0;
+    scroll_offset = 0;
+    recount_completed();
+}
+
+void TaskListView::rebuild_task_positions()
+{
+    task_positions.clear();
+    task_positions.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        task_positions[tasks[i].id] = i;
+    }
+}
+
+size_t TaskListView::find_task_index(int task_id)
+{
+    auto it = task_positions.find(task_id);
+    if (it == task_positions.end())
+    {
+        return tasks.size();
+    }
+
+    // Rows inserted or moved above the task shift it; positions are taken again only then
+    if (it->second >= tasks.size() || tasks[it->second].id != task_id)
+    {
+        rebuild_task_positions();
+        it = task_positions.find(task_id);
+        if (it == task_positions.end())
+        {
+            return tasks.size();
+        }
+    }
+    return it->second;
+}
+
+void TaskListView::invalidate_row(int task_id)
+{
+    row_versions[task_id] = ++row_generation;
+}
+
+const TaskListView::RowCacheEntry &TaskListView::cached_row(size_t index)
+{
+    const Task &task = tasks[index];
+    auto version = row_versions.find(task.id);
+    unsigned long long current_version = version != row_versions.end() ? version->second : 0;
+    bool overdue = task.is_overdue();
+
+    auto it = row_cache.find(task.id);
+    if (it != row_cache.end() && it->second.version == current_version &&
+        it->second.depth == task_depths[index] && it->second.overdue == overdue)
+    {
+        return it->second;
+    }
+
+    // Row changed since it was last drawn (or was never drawn): format it again
+    RowCacheEntry &entry = row_cache[task.id];
+    entry.version = current_version;
+    entry.depth = task_depths[index];
+    entry.overdue = overdue;
+    entry.text = format_task(task, task_depths[index], false);
+
+    auto task_text = ftxui::text(entry.text);
+    if (overdue)
+    {
+        entry.element = task_text | ftxui::color(ftxui::Color::Red);
+    }
+    else if (task.is_completed)
+    {
+        entry.element = task_text | ftxui::dim;
+    }
+    else
+    {
+        entry.element = task_text;
+    }
+    return entry;
+}
+
+bool TaskListView::sorts_before(const Task &a, const Task &b)
+{
+    // Same order as the task query: priority DESC, due_date ASC with no date first
+    if (a.priority != b.priority)
+    {
+        return a.priority > b.priority;
+    }
+    if (a.due_date.has_value() != b.due_date.has_value())
+    {
+        return !a.due_date.has_value();
+    }
+    return a.due_date.has_value() && a.due_date.value() < b.due_date.value();
+}
+
+bool TaskListView::counts_as_done(const Task &task)
+{
+    return task.is_completed || task.status == 4;
+}
+
+size_t TaskListView::subtree_end(size_t index) const
+{
+    size_t end = index + 1;
+    while (end < tasks.size() && task_depths[end] > task_depths[index])
+    {
+        end++;
+    }
+    return end;
+}
+
+size_t TaskListView::sibling_position(const Task &task, size_t begin, size_t end, int depth) const
+{
+    // Walk the siblings in [begin, end), skipping over their subtrees
+    size_t pos = begin;
+    while (pos < end)
+    {
+        if (task_depths[pos] == depth && sorts_before(task, tasks[pos]))
+        {
+            return pos;
+        }
+        pos = subtree_end(pos);
+    }
+    return end;
+}
+
+void TaskListView::adjust_subtask_counts(const Task &task, int total_delta, int completed_delta)
+{
+    if (!task.is_subtask())
+    {
+        return;
+    }
+
+    invalidate_row(task.parent_id.value());
+
+    SubtaskCounts &counts = subtask_counts[task.parent_id.value()];
+    counts.total += total_delta;
+    counts.completed += completed_delta;
+    if (counts.total <= 0)
+    {
+        subtask_counts.erase(task.parent_id.value());
+    }
+}
+
+bool TaskListView::patch_task_inserted(const Task &task)
+{
+    if (!tag_filter.empty())
+    {
+        return false; // Filtered lists are rebuilt from a full reload
+    }
+
+    adjust_subtask_counts(task, 1, counts_as_done(task) ? 1 : 0);
+    details_task_id = -1;
+
+    if (!show_completed && task.is_completed)
+    {
+        return true; // Hidden in this view
+    }
+
+    size_t begin = 0;
+    size_t end = tasks.size();
+    int depth = 0;
 
-    // Indentation for subtasks
     if (task.is_subtask())
     {
-        ss << "  ↳ ";
+        size_t parent_index = find_task_index(task.parent_id.value());
+        if (parent_index >= tasks.size())
+        {
+            return false;
+        }
+        begin = parent_index + 1;
+        end = subtree_end(parent_index);
+        depth = task_depths[parent_index] + 1;
+    }
+
+    size_t pos = sibling_position(task, begin, end, depth);
+    tasks.insert(tasks.begin() + pos, task);
+    task_depths.insert(task_depths.begin() + pos, depth);
+    task_positions[task.id] = pos;
+    tag_index.add_task(task);
+    completed_task_count += task.is_completed ? 1 : 0;
+
+    // Keep the same task selected
+    if (tasks.size() > 1 && static_cast<int>(pos) <= selected_index)
+    {
+        selected_index++;
+    }
+    return true;
+}
+
+bool TaskListView::patch_task_updated(size_t index, const Task &task)
+{
+    if (!tag_filter.empty() || index >= tasks.size() || tasks[index].id != task.id ||
+        tasks[index].parent_id != task.parent_id)
+    {
+        return false; // Moved to another parent: let a full reload place it
+    }
+
+    const Task &old_task = tasks[index];
+    adjust_subtask_counts(task, 0, (counts_as_done(task) ? 1 : 0) - (counts_as_done(old_task) ? 1 : 0));
+    details_task_id = -1;
+
+    if (!show_completed && task.is_completed)
+    {
+        return patch_task_removed(index, false);
+    }
+
+    bool reposition = sorts_before(task, old_task) || sorts_before(old_task, task);
+    completed_task_count += (task.is_completed ? 1 : 0) - (old_task.is_completed ? 1 : 0);
+    tag_index.remove_task(old_task);
+    tag_index.add_task(task);
+    tasks[index] = task;
+    invalidate_row(task.id);
+    if (!reposition)
+    {
+        return true;
+    }
+
+    // Sort key changed: move the task together with its subtasks among its siblings
+    size_t block_end = subtree_end(index);
+    int depth = task_depths[index];
+    vector<Task> block(std::make_move_iterator(tasks.begin() + index),
+                       std::make_move_iterator(tasks.begin() + block_end));
+    vector<int> block_depths(task_depths.begin() + index, task_depths.begin() + block_end);
+    tasks.erase(tasks.begin() + index, tasks.begin() + block_end);
+    task_depths.erase(task_depths.begin() + index, task_depths.begin() + block_end);
+
+    size_t begin = 0;
+    size_t end = tasks.size();
+    if (depth > 0)
+    {
+        // The parent is the closest earlier row one level up
+        size_t parent_index = index;
+        while (parent_index > 0 && task_depths[parent_index - 1] != depth - 1)
+        {
+            parent_index--;
+        }
+        begin = parent_index;
+        end = subtree_end(parent_index - 1);
+    }
+
+    size_t pos = sibling_position(block.front(), begin, end, depth);
+    tasks.insert(tasks.begin() + pos, std::make_move_iterator(block.begin()), std::make_move_iterator(block.end()));
+    task_depths.insert(task_depths.begin() + pos, block_depths.begin(), block_depths.end());
+
+    // Follow the moved task with the selection
+    if (selected_index == static_cast<int>(index))
+    {
+        selected_index = static_cast<int>(pos);
+    }
+    return true;
+}
+
+bool TaskListView::patch_task_removed(size_t index, bool deleted)
+{
+    if (!tag_filter.empty() || index >= tasks.size())
+    {
+        return false;
+    }
+
+    if (deleted)
+    {
+        adjust_subtask_counts(tasks[index], -1, counts_as_done(tasks[index]) ? -1 : 0);
+        subtask_counts.erase(tasks[index].id);
+    }
+    details_task_id = -1;
+
+    // Subtasks are shown only under their parent, so they leave with it
+    size_t block_end = subtree_end(index);
+    for (size_t i = index; i < block_end; ++i)
+    {
+        row_cache.erase(tasks[i].id);
+        row_versions.erase(tasks[i].id);
+        marked_task_ids.erase(tasks[i].id);
+        task_positions.erase(tasks[i].id);
+        tag_index.remove_task(tasks[i]);
+        completed_task_count -= tasks[i].is_completed ? 1 : 0;
+    }
+    tasks.erase(tasks.begin() + index, tasks.begin() + block_end);
+    task_depths.erase(task_depths.begin() + index, task_depths.begin() + block_end);
+
+    if (selected_index >= static_cast<int>(block_end))
+    {
+        selected_index -= static_cast<int>(block_end - index);
+    }
+    if (selected_index >= static_cast<int>(tasks.size()))
+    {
+        selected_index = tasks.size() > 0 ? tasks.size() - 1 : 0;
+    }
+    return true;
+}
+
+void TaskListView::notify_external_changes()
+{
+    screen.Post([this]
+                { load_external_changes(); });
+    screen.PostEvent(Event::Custom);
+}
+
+void TaskListView::load_external_changes()
+{
+    TaskDelta delta = db.get_tasks_changed_since(change_mark);
+    change_mark = delta.next_since;
+
+    // Rows changed in the millisecond of the old mark come back every time. A row
+    // is skipped while it still reads as listed, or as the last delta returned it
+    // if it is not listed. Whether a task is new to the list is decided when patching.
+    vector<TaskChange> changes;
+    unordered_map<int, Task> rows;
+    unordered_map<int, Task> seen_rows;
+    for (auto &task : delta.changed)
+    {
+        size_t index = find_task_index(task.id);
+        auto seen = delta_rows.find(task.id);
+        bool unchanged = index < tasks.size() ? same_task(tasks[index], task)
+                                              : seen != delta_rows.end() && same_task(seen->second, task);
+        seen_rows[task.id] = task;
+        if (!unchanged)
+        {
+            changes.push_back(TaskChange{TaskChangeType::Updated, task.id});
+            rows[task.id] = std::move(task);
+        }
+    }
+    unordered_set<int> seen_deleted_ids(delta.deleted_ids.begin(), delta.deleted_ids.end());
+    for (int task_id : delta.deleted_ids)
+    {
+        if (!delta_deleted_ids.count(task_id))
+        {
+            changes.push_back(TaskChange{TaskChangeType::Deleted, task_id});
+        }
+    }
+    delta_rows = std::move(seen_rows);
+    delta_deleted_ids = std::move(seen_deleted_ids);
+    if (changes.empty())
+    {
+        return;
+    }
+
+    if (redis && redis->is_connected())
+    {
+        redis->invalidate_changes(changes);
+    }
+    patch_task_changes(changes, rows);
+    status_message = "Reloaded changes made outside this window.";
+}
+
+void TaskListView::apply_task_changes(const vector<TaskChange> &changes)
+{
+    // Rows this connection changed no longer read as the last delta returned them
+    for (const auto &change : changes)
+    {
+        delta_rows.erase(change.task_id);
+    }
+    patch_task_changes(changes, {});
+}
+
+void TaskListView::patch_task_changes(const vector<TaskChange> &changes, const unordered_map<int, Task> &rows)
+{
+    if (!tag_filter.empty() || changes.size() > MAX_PATCHED_CHANGES)
+    {
+        refresh_tasks();
+        return;
+    }
+
+    bool reload_counts = false;
+    bool reload_tags = false;
+    for (const auto &change : changes)
+    {
+        size_t index = find_task_index(change.task_id);
+        bool listed = index < tasks.size();
+
+        if (change.type == TaskChangeType::Deleted)
+        {
+            if (!listed)
+            {
+                // Already removed from the list, or hidden with the completed tasks
+                reload_counts = reload_counts || !show_completed;
+            }
+            else if (!patch_task_removed(index, true))
+            {
+                refresh_tasks();
+                return;
+            }
+            continue;
+        }
+
+        auto row = rows.find(change.task_id);
+        auto task = row != rows.end() ? optional<Task>(row->second) : db.get_task_by_id(change.task_id);
+        if (!task.has_value())
+        {
+            continue; // Deleted by a later commit; its change follows
+        }
+        for (int tag_id : task->tags)
+        {
+            reload_tags = reload_tags || !tag_names.count(tag_id);
+        }
+
+        bool patched;
+        if (listed)
+        {
+            patched = patch_task_updated(index, task.value());
+        }
+        else
+        {
+            // A new task, or one that was hidden with the completed tasks and is
+            // already part of the subtask counts
+            patched = patch_task_inserted(task.value());
+            reload_counts = reload_counts || change.type != TaskChangeType::Inserted;
+        }
+
+        if (!patched)
+        {
+            refresh_tasks();
+            return;
+        }
+    }
+
+    if (reload_tags)
+    {
+        for (const auto &tag : db.get_all_tags())
+        {
+            tag_names[tag.id] = tag.name;
+        }
+        row_cache.clear();
+        details_task_id = -1;
+    }
+    if (reload_counts)
+    {
+        subtask_counts = db.get_subtask_counts();
+        row_cache.clear();
+        details_task_id = -1;
+    }
+}
+
+string TaskListView::format_task(const Task &task, int depth, bool is_selected) const
+{
+    stringstream ss;
+
+    // Indentation for subtasks, one step per nesting level
+    if (depth > 0)
+    {
+        ss << string(2 * depth, ' ') << "↳ ";
+    }
+
+    // Marked for a bulk action
+    if (marked_task_ids.count(task.id))
+    {
+        ss << "● ";
     }
 
     // Status-based checkbox
@@ -121,21 +715,35 @@ string TaskListView::format_task(const Task &task, bool is_selected) const
     }
 
     // Subtask count
-    auto subtasks = db.get_subtasks(task.id);
-    if (!subtasks.empty())
+    auto counts = subtask_counts.find(task.id);
+    if (counts != subtask_counts.end() && counts->second.total > 0)
     {
-        int completed = 0;
-        for (const auto &st : subtasks)
-        {
-            if (st.is_completed || st.status == 4)
-                completed++;
-        }
-        ss << " (" << completed << "/" << subtasks.size() << " subtasks)";
+        ss << " (" << counts->second.completed << "/" << counts->second.total << " subtasks)";
+    }
+
+    // Tags
+    if (!task.tags.empty())
+    {
+        ss << " " << format_tags(task.tags);
     }
 
     return ss.str();
 }
 
+string TaskListView::format_tags(const vector<int> &tag_ids, const string &separator) const
+{
+    string text;
+    for (int tag_id : tag_ids)
+    {
+        auto name = tag_names.find(tag_id);
+        if (name != tag_names.end())
+        {
+            text += (text.empty() ? "#" : separator + "#") + name->second;
+        }
+    }
+    return text;
+}
+
 string TaskListView::format_task_details(const Task &task) const
 {
     stringstream ss;
@@ -201,6 +809,12 @@ string TaskListView::format_task_details(const Task &task) const
         ss << "] " << task.progress << "%\n";
     }
 
+    // Tags
+    if (!task.tags.empty())
+    {
+        ss << "\nTags: " << format_tags(task.tags) << "\n";
+    }
+
     // Links
     if (!task.links.empty())
     {
@@ -259,45 +873,92 @@ string TaskListView::format_task_details(const Task &task) const
     return ss.str();
 }
 
-Component TaskListView::create_task_list()
+int TaskListView::panel_rows(const PanelLayout &panel, int chrome_rows) const
 {
-    return Renderer([&]
-                    {
-        ftxui::Elements task_elements;
+    // An untouched box is all zeros: not laid out yet, so estimate from the terminal
+    if (panel.screen_rows == 0 || panel.box.y_max <= panel.box.y_min)
+    {
+        return std::max(1, screen.dimy() - chrome_rows);
+    }
 
-        if (tasks.empty())
-        {
-            task_elements.push_back(ftxui::text("No tasks found. Press 'a' to add a new task.") | ftxui::center);
-        }
-        else
-        {
-            for (size_t i = 0; i < tasks.size(); ++i)
-            {
-                const auto &task = tasks[i];
-                bool is_selected = (static_cast<int>(i) == selected_index);
+    // The panel gets whatever height the rest of the view leaves, so it
+    // grows and shrinks with the terminal
+    int measured = panel.box.y_max - panel.box.y_min + 1;
+    return std::max(1, measured + screen.dimy() - panel.screen_rows);
+}
 
-                auto task_text = ftxui::text(format_task(task, is_selected));
+int TaskListView::begin_panel(PanelLayout &panel, int chrome_rows)
+{
+    int rows = panel_rows(panel, chrome_rows);
+    panel.screen_rows = screen.dimy();
+    return rows;
+}
 
-                if (is_selected)
-                {
-                    task_elements.push_back(task_text | ftxui::inverted | ftxui::bold);
-                }
-                else if (task.is_overdue())
-                {
-                    task_elements.push_back(task_text | ftxui::color(ftxui::Color::Red));
-                }
-                else if (task.is_completed)
-                {
-                    task_elements.push_back(task_text | ftxui::dim);
-                }
-                else
-                {
-                    task_elements.push_back(task_text);
-                }
-            }
-        }
+int TaskListView::visible_task_rows() const
+{
+    return panel_rows(task_list_layout, LIST_CHROME_ROWS);
+}
+
+void TaskListView::recount_completed()
+{
+    completed_task_count = static_cast<int>(std::count_if(tasks.begin(), tasks.end(), [](const Task &t)
+                                                          { return t.is_completed; }));
+}
+
+Elements TaskListView::render_task_rows()
+{
+    Elements task_elements;
+
+    // The caller reflects the panel into task_list_layout
+    int rows = begin_panel(task_list_layout, LIST_CHROME_ROWS);
 
-        return ftxui::vbox(task_elements) | ftxui::vscroll_indicator | ftxui::frame | ftxui::flex; });
+    if (tasks.empty())
+    {
+        task_elements.push_back(ftxui::text("No tasks found. Press 'a' to add a new task.") | ftxui::center);
+        return task_elements;
+    }
+
+    // Keep the selected row inside the window [scroll_offset, scroll_offset + rows)
+    int total = static_cast<int>(tasks.size());
+    if (selected_index < scroll_offset)
+    {
+        scroll_offset = selected_index;
+    }
+    else if (selected_index >= scroll_offset + rows)
+    {
+        scroll_offset = selected_index - rows + 1;
+    }
+    scroll_offset = std::max(0, std::min(scroll_offset, total - rows));
+
+    // A few rows on each side of the window are built as well. The window is
+    // focused, and a frame centres its focus, so a block exactly one viewport
+    // tall is scrolled flush with the top and the extra rows stay out of view.
+    int first = std::max(0, scroll_offset - ROW_OVERSCAN);
+    int window_end = std::min(total, scroll_offset + rows);
+    int last = std::min(total, window_end + ROW_OVERSCAN);
+
+    auto row_element = [&](int i)
+    {
+        const RowCacheEntry &row = cached_row(i);
+        return i == selected_index ? ftxui::text(row.text) | ftxui::inverted | ftxui::bold : row.element;
+    };
+
+    for (int i = first; i < scroll_offset; ++i)
+    {
+        task_elements.push_back(row_element(i));
+    }
+    Elements window;
+    for (int i = scroll_offset; i < window_end; ++i)
+    {
+        window.push_back(row_element(i));
+    }
+    task_elements.push_back(ftxui::vbox(std::move(window)) | ftxui::focus);
+    for (int i = window_end; i < last; ++i)
+    {
+        task_elements.push_back(row_element(i));
+    }
+
+    return task_elements;
 }
 
 Component TaskListView::create_menu()
@@ -313,6 +974,7 @@ Component TaskListView::create_menu()
                                  ftxui::text("[c]ompleted "),
                                  ftxui::text("[g]settings "),
                                  ftxui::text("[G]sync "),
+                                 ftxui::text("[b]ackup "),
                                  ftxui::text("[h]elp "),
                                  ftxui::text("[q]uit "),
                              }) |
@@ -329,23 +991,30 @@ Element TaskListView::render()
 
     // Status bar with overall progress
     int total_tasks = tasks.size();
-    int completed_tasks = 0;
-    for (const auto &task : tasks)
-    {
-        if (task.is_completed)
-            completed_tasks++;
-    }
+    int completed_tasks = completed_task_count;
 
     float completion_percentage = total_tasks > 0 ? (float)completed_tasks / total_tasks : 0.0f;
 
+    Elements status_items = {
+        ftxui::text(status_message),
+        ftxui::separator(),
+        ftxui::text(" Tasks: " + to_string(tasks.size())),
+        ftxui::separator(),
+    };
+    if (!marked_task_ids.empty())
+    {
+        status_items.push_back(ftxui::text(" Marked: " + to_string(marked_task_ids.size()) + " "));
+        status_items.push_back(ftxui::separator());
+    }
+    if (!tag_filter.empty())
+    {
+        status_items.push_back(ftxui::text(" Filter: " + format_tags(tag_filter) + " ") | ftxui::color(ftxui::Color::Cyan));
+        status_items.push_back(ftxui::separator());
+    }
+    status_items.push_back(ftxui::text(show_completed ? " [All]" : " [Active]"));
+
     auto status_bar = ftxui::vbox({
-                          ftxui::hbox({
-                              ftxui::text(status_message),
-                              ftxui::separator(),
-                              ftxui::text(" Tasks: " + to_string(tasks.size())),
-                              ftxui::separator(),
-                              ftxui::text(show_completed ? " [All]" : " [Active]"),
-                          }),
+                          ftxui::hbox(std::move(status_items)),
                           ftxui::hbox({
                               ftxui::text("Progress: "),
                               ftxui::gauge(completion_percentage) | ftxui::flex,
@@ -359,49 +1028,22 @@ Element TaskListView::render()
 
     if (current_view == "list")
     {
-        // Create task list
-        ftxui::Elements task_elements;
-
-        if (tasks.empty())
-        {
-            task_elements.push_back(ftxui::text("No tasks found. Press 'a' to add a new task.") | ftxui::center);
-        }
-        else
-        {
-            for (size_t i = 0; i < tasks.size(); ++i)
-            {
-                const auto &task = tasks[i];
-                bool is_selected = (static_cast<int>(i) == selected_index);
-
-                auto task_text = ftxui::text(format_task(task, is_selected));
-
-                if (is_selected)
-                {
-                    task_elements.push_back(task_text | ftxui::inverted | ftxui::bold);
-                }
-                else if (task.is_overdue())
-                {
-                    task_elements.push_back(task_text | ftxui::color(ftxui::Color::Red));
-                }
-                else if (task.is_completed)
-                {
-                    task_elements.push_back(task_text | ftxui::dim);
-                }
-                else
-                {
-                    task_elements.push_back(task_text);
-                }
-            }
-        }
-
-        auto task_list_element = ftxui::vbox(task_elements) | ftxui::vscroll_indicator | ftxui::frame | ftxui::border;
+        // Create task list (only the rows inside the viewport are built)
+        auto task_list_element = ftxui::vbox(render_task_rows()) | ftxui::vscroll_indicator | ftxui::frame |
+                                 ftxui::reflect(task_list_layout.box) | ftxui::border;
 
         // Create task details panel
         Element details_panel;
         if (!tasks.empty() && selected_index < static_cast<int>(tasks.size()))
         {
+            // Details need database lookups, so only rebuild them when the selection changes
+            if (details_task_id != tasks[selected_index].id)
+            {
+                details_text = format_task_details(tasks[selected_index]);
+                details_task_id = tasks[selected_index].id;
+            }
+
             // Split details text into lines for proper display
-            string details_text = format_task_details(tasks[selected_index]);
             ftxui::Elements detail_lines;
             stringstream ss(details_text);
             string line;
@@ -432,6 +1074,73 @@ Element TaskListView::render()
             status_bar,
         });
     }
+    else if (current_view == "search")
+    {
+        // Results window follows the selection; the results panel is reflected into search_layout
+        int rows = begin_panel(search_layout, SEARCH_CHROME_ROWS);
+        int total = static_cast<int>(search_results.size());
+        int first = std::max(0, std::min(search_selected - rows / 2, total - rows));
+
+        Elements result_rows;
+        for (int i = first; i < std::min(total, first + rows); ++i)
+        {
+            Element row = ftxui::text(format_task(search_results[i], 0, i == search_selected));
+            if (static_cast<size_t>(i) >= archived_results_start)
+            {
+                row = ftxui::hbox({ftxui::text("[archived] ") | ftxui::dim, row});
+            }
+            result_rows.push_back(i == search_selected ? row | ftxui::inverted | ftxui::bold : row);
+        }
+        if (result_rows.empty())
+        {
+            result_rows.push_back(ftxui::text(search_query.empty() ? "Type to search descriptions and links" : "No matching tasks") | ftxui::center);
+        }
+
+        content = ftxui::vbox({
+            header,
+            ftxui::hbox({
+                ftxui::text("/ ") | ftxui::bold,
+                ftxui::text(search_query + "_") | ftxui::color(ftxui::Color::Yellow) | ftxui::flex,
+                ftxui::text(" " + to_string(total) + " result(s) "),
+            }) | ftxui::border,
+            ftxui::vbox(result_rows) | ftxui::frame | ftxui::reflect(search_layout.box) | ftxui::border | ftxui::flex,
+            ftxui::text(string("Type to search | \"phrase\" for exact match | ↑/↓ - Select | Enter - Go to task | ") +
+                        (db.has_archive() ? (search_archive ? "Tab - Hide archive | " : "Tab - Search archive | ") : "") + "ESC - Cancel") |
+                ftxui::center,
+            status_bar,
+        });
+    }
+    else if (current_view == "tag_filter")
+    {
+        // Known tags with the number of loaded tasks carrying each
+        vector<std::pair<string, int>> known_tags;
+        for (const auto &[tag_id, name] : tag_names)
+        {
+            known_tags.emplace_back(name, tag_id);
+        }
+        std::sort(known_tags.begin(), known_tags.end());
+
+        Elements tag_rows;
+        for (const auto &[name, tag_id] : known_tags)
+        {
+            tag_rows.push_back(ftxui::text("#" + name + " (" + to_string(tag_index.count(tag_id)) + ")"));
+        }
+        if (tag_rows.empty())
+        {
+            tag_rows.push_back(ftxui::text("No tags yet. Add tags in the task dialog.") | ftxui::center);
+        }
+
+        content = ftxui::vbox({
+            header,
+            ftxui::hbox({
+                ftxui::text("# ") | ftxui::bold,
+                ftxui::text(tag_filter_input + "_") | ftxui::color(ftxui::Color::Yellow) | ftxui::flex,
+            }) | ftxui::border,
+            ftxui::vbox(tag_rows) | ftxui::vscroll_indicator | ftxui::frame | ftxui::border | ftxui::flex,
+            ftxui::text("Tag names separated by spaces (tasks must have all) | Enter - Apply, empty clears | ESC - Cancel") | ftxui::center,
+            status_bar,
+        });
+    }
     else if (current_view == "help")
     {
         content = ftxui::vbox({
@@ -445,17 +1154,23 @@ Element TaskListView::render()
                 ftxui::text("  e - Edit selected task"),
                 ftxui::text("  d - Delete selected task (with confirmation)"),
                 ftxui::text("  Space - Toggle task completion"),
+                ftxui::text("  m - Mark/unmark task for bulk actions, M - Clear marks"),
+                ftxui::text("  Space/d with marked tasks - Complete/delete all marked"),
                 ftxui::text("  c - Toggle show/hide completed tasks"),
+                ftxui::text("  / - Search descriptions and links"),
+                ftxui::text("  # - Filter by tags"),
                 ftxui::text("  s - Get AI suggestions for selected task"),
                 ftxui::text("  S - Get AI schedule summary"),
                 ftxui::text("  g - Open settings"),
                 ftxui::text("  G - Sync tasks to Google Sheets ★"),
+                ftxui::text("  b - Back up the database in the background"),
                 ftxui::text("  h - Show this help"),
                 ftxui::text("  q - Quit application"),
                 ftxui::text("  ↑/↓ - Navigate tasks"),
+                ftxui::text("  PgUp/PgDn/Home/End - Jump through the list"),
                 ftxui::text(""),
                 ftxui::text("In Add/Edit Dialog:"),
-                ftxui::text("  Tab - Switch between fields (Description/Date/Link/Progress)"),
+                ftxui::text("  Tab - Switch between fields (Description/Date/Link/Progress/Status/Tags)"),
                 ftxui::text("  Type - Edit active field (highlighted in yellow)"),
                 ftxui::text("  +/- - Adjust priority or progress"),
                 ftxui::text("  Backspace - Delete character"),
@@ -479,6 +1194,20 @@ Element TaskListView::render()
             ai_lines.push_back(ftxui::text(line));
         }
 
+        Element footer = ftxui::text("Press any key to return...") | ftxui::center;
+        if (ai_busy)
+        {
+            auto frame = static_cast<size_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                 std::chrono::steady_clock::now().time_since_epoch())
+                                                 .count() /
+                                             100);
+            ai_lines.push_back(ftxui::hbox({
+                ftxui::spinner(2, frame),
+                ftxui::text(" Waiting for the model..."),
+            }));
+            footer = ftxui::text("Press ESC to cancel") | ftxui::center;
+        }
+
         content = ftxui::vbox({
             header,
             ftxui::vbox({
@@ -486,7 +1215,7 @@ Element TaskListView::render()
                 ftxui::separator(),
                 ftxui::vbox(ai_lines) | ftxui::vscroll_indicator | ftxui::frame | ftxui::flex,
                 ftxui::separator(),
-                ftxui::text("Press any key to return...") | ftxui::center,
+                footer,
             }) | ftxui::border |
                 ftxui::flex,
             status_bar,
@@ -502,6 +1231,7 @@ Element TaskListView::render()
         auto date_style = (current_input_field == 1) ? ftxui::bold | ftxui::color(ftxui::Color::Yellow) : ftxui::nothing;
         auto link_style = (current_input_field == 2) ? ftxui::bold | ftxui::color(ftxui::Color::Yellow) : ftxui::nothing;
         auto progress_style = (current_input_field == 3) ? ftxui::bold | ftxui::color(ftxui::Color::Yellow) : ftxui::nothing;
+        auto tags_style = (current_input_field == 5) ? ftxui::bold | ftxui::color(ftxui::Color::Yellow) : ftxui::nothing;
         auto status_style = (current_input_field == 4) ? ftxui::bold | ftxui::color(ftxui::Color::Yellow) : ftxui::nothing;
 
         string status_text;
@@ -544,6 +1274,8 @@ Element TaskListView::render()
                 ftxui::separator(),
                 ftxui::hbox({ftxui::text("[Progress]: "), ftxui::text(to_string(input_progress) + "%") | ftxui::flex}) | progress_style,
                 ftxui::separator(),
+                ftxui::hbox({ftxui::text("[Tags]: "), ftxui::text(input_tags.empty() ? "work, home" : input_tags) | ftxui::flex}) | tags_style,
+                ftxui::separator(),
                 ftxui::hbox({ftxui::text("[Status]: "), ftxui::text(status_text) | ftxui::flex}) | status_style,
                 ftxui::separator(),
                 ftxui::text(""),
@@ -558,12 +1290,12 @@ Element TaskListView::render()
             status_bar,
         });
     }
-    else if (current_view == "delete_confirm")
+    else if (current_view == "delete_confirm" || current_view == "bulk_delete_confirm")
     {
         content = ftxui::vbox({
             header,
             ftxui::vbox({
-                ftxui::text("Delete Task") | ftxui::bold | ftxui::center | ftxui::color(ftxui::Color::Red),
+                ftxui::text(current_view == "bulk_delete_confirm" ? "Delete Tasks" : "Delete Task") | ftxui::bold | ftxui::center | ftxui::color(ftxui::Color::Red),
                 ftxui::text(""),
                 ftxui::text(status_message) | ftxui::center,
                 ftxui::text(""),
@@ -580,6 +1312,7 @@ Element TaskListView::render()
         auto date_style = (current_input_field == 1) ? ftxui::bold | ftxui::color(ftxui::Color::Yellow) : ftxui::nothing;
         auto link_style = (current_input_field == 2) ? ftxui::bold | ftxui::color(ftxui::Color::Yellow) : ftxui::nothing;
         auto progress_style = (current_input_field == 3) ? ftxui::bold | ftxui::color(ftxui::Color::Yellow) : ftxui::nothing;
+        auto tags_style = (current_input_field == 5) ? ftxui::bold | ftxui::color(ftxui::Color::Yellow) : ftxui::nothing;
 
         content = ftxui::vbox({
             header,
@@ -600,6 +1333,8 @@ Element TaskListView::render()
                 ftxui::separator(),
                 ftxui::hbox({ftxui::text("[Progress]: "), ftxui::text(to_string(input_progress) + "%") | ftxui::flex}) | progress_style,
                 ftxui::separator(),
+                ftxui::hbox({ftxui::text("[Tags]: "), ftxui::text(input_tags.empty() ? "work, home" : input_tags) | ftxui::flex}) | tags_style,
+                ftxui::separator(),
                 ftxui::text("Tab - Switch | +/- - Priority/Progress | Enter - Save | ESC - Cancel"),
             }) | ftxui::border |
                 ftxui::center,
@@ -654,6 +1389,7 @@ void TaskListView::add_task_dialog()
     input_link = "";
     input_progress = 0;
     input_status = 0; // New
+    input_tags = "";
     current_input_field = 0;
 
     current_view = "add";
@@ -667,7 +1403,7 @@ void TaskListView::toggle_task_completion()
         return;
     }
 
-    Task &task = tasks[selected_index];
+    Task task = tasks[selected_index];
     task.is_completed = !task.is_completed;
 
     // Sync status and progress with completion state
@@ -685,89 +1421,413 @@ void TaskListView::toggle_task_completion()
         }
     }
 
-    if (db.update_task(task))
+    // Show the change now; the write is committed in the background
+    status_message = task.is_completed ? "Task marked as completed!" : "Task marked as pending!";
+    bool patched = patch_task_updated(selected_index, task);
+
+    submit_write([task](DatabaseManager &writer_db)
+                 { return writer_db.update_task(task); },
+                 [this, task](bool ok)
+                 {
+                     if (!ok)
+                     {
+                         status_message = "Failed to update task.";
+                         refresh_tasks();
+                         return;
+                     }
+
+                     // Update cache
+                     if (redis && redis->is_connected())
+                     {
+                         redis->cache_task(task);
+                     }
+                 });
+
+    if (!patched)
     {
-        status_message = task.is_completed ? "Task marked as completed!" : "Task marked as pending!";
+        refresh_tasks();
+    }
+}
 
-        // Update cache
-        if (redis && redis->is_connected())
-        {
-            redis->cache_task(task);
-        }
+void TaskListView::toggle_task_mark()
+{
+    if (tasks.empty() || selected_index >= static_cast<int>(tasks.size()))
+    {
+        status_message = "No task selected.";
+        return;
+    }
 
-        refresh_tasks();
+    int task_id = tasks[selected_index].id;
+    if (!marked_task_ids.erase(task_id))
+    {
+        marked_task_ids.insert(task_id);
+    }
+    invalidate_row(task_id);
 
-        // Force UI refresh to update display immediately
-        screen.PostEvent(Event::Custom);
+    if (selected_index < static_cast<int>(tasks.size()) - 1)
+    {
+        selected_index++;
     }
-    else
+    status_message = to_string(marked_task_ids.size()) + " task(s) marked.";
+}
+
+void TaskListView::clear_task_marks()
+{
+    for (int task_id : marked_task_ids)
     {
-        status_message = "Failed to update task.";
+        invalidate_row(task_id);
     }
+    marked_task_ids.clear();
+    status_message = "Marks cleared.";
 }
 
-void TaskListView::delete_task_dialog()
+void TaskListView::toggle_marked_completion()
 {
-    if (tasks.empty() || selected_index >= static_cast<int>(tasks.size()))
+    vector<int> ids(marked_task_ids.begin(), marked_task_ids.end());
+
+    // Reopen only when every marked task is already done
+    bool all_completed = std::all_of(tasks.begin(), tasks.end(), [&](const Task &t)
+                                     { return !marked_task_ids.count(t.id) || t.is_completed; });
+
+    TaskPatch patch;
+    patch.is_completed = !all_completed;
+    if (all_completed)
     {
-        status_message = "No task selected.";
-        return;
+        patch.status = 0; // New
+    }
+    else
+    {
+        patch.status = 4; // Completed
+        patch.progress = 100;
     }
 
-    current_view = "delete_confirm";
-    const Task &task = tasks[selected_index];
-    status_message = "Delete task: \"" + task.description + "\"? (y/N)";
+    auto updated = std::make_shared<int>(0);
+    marked_task_ids.clear();
+    status_message = "Updating " + to_string(ids.size()) + " task(s)...";
+
+    submit_write([ids, patch, updated](DatabaseManager &writer_db)
+                 {
+                     *updated = writer_db.update_tasks(ids, patch);
+                     return *updated >= 0; },
+                 [this, updated, all_completed](bool ok)
+                 {
+                     // The change feed has already patched the list
+                     if (!ok)
+                     {
+                         status_message = "Failed to update marked tasks.";
+                         return;
+                     }
+                     status_message = to_string(*updated) + (all_completed ? " task(s) marked as pending." : " task(s) marked as completed.");
+                 });
 }
 
-void TaskListView::confirm_delete()
+void TaskListView::bulk_delete_dialog()
 {
-    if (tasks.empty() || selected_index >= static_cast<int>(tasks.size()))
+    current_view = "bulk_delete_confirm";
+    status_message = "Delete " + to_string(marked_task_ids.size()) + " marked task(s) and their subtasks? (y/N)";
+}
+
+void TaskListView::confirm_bulk_delete()
+{
+    vector<int> ids(marked_task_ids.begin(), marked_task_ids.end());
+    auto deleted = std::make_shared<int>(0);
+
+    marked_task_ids.clear();
+    current_view = "list";
+    status_message = "Deleting " + to_string(ids.size()) + " task(s)...";
+
+    submit_write([ids, deleted](DatabaseManager &writer_db)
+                 {
+                     *deleted = writer_db.delete_tasks(ids);
+                     return *deleted >= 0; },
+                 [this, deleted](bool ok)
+                 {
+                     // The change feed has already patched the list
+                     if (!ok)
+                     {
+                         status_message = "Failed to delete marked tasks.";
+                         return;
+                     }
+                     status_message = to_string(*deleted) + " task(s) deleted.";
+                 });
+}
+
+void TaskListView::start_search()
+{
+    search_query.clear();
+    search_results.clear();
+    archived_results_start = 0;
+    search_selected = 0;
+    current_view = "search";
+    status_message = "Search tasks";
+}
+
+void TaskListView::update_search()
+{
+    search_results = search_query.empty() ? vector<Task>() : db.search_tasks(search_query, SEARCH_RESULT_LIMIT);
+    archived_results_start = search_results.size();
+
+    // The archive is only read on request
+    if (search_archive && !search_query.empty())
     {
-        current_view = "list";
-        status_message = "No task selected.";
+        vector<Task> archived = db.search_archive(search_query, SEARCH_RESULT_LIMIT);
+        search_results.insert(search_results.end(), archived.begin(), archived.end());
+    }
+    search_selected = 0;
+}
+
+void TaskListView::open_search_result()
+{
+    current_view = "list";
+    if (search_results.empty() || search_selected >= static_cast<int>(search_results.size()))
+    {
+        status_message = "Search closed.";
         return;
     }
 
-    const Task &task = tasks[selected_index];
+    const Task target = search_results[search_selected];
+    if (static_cast<size_t>(search_selected) >= archived_results_start)
+    {
+        status_message = "Archived task: " + target.description;
+        return;
+    }
 
-    show_progress = true;
-    progress_value = 0;
-    progress_message = "Deleting task...";
-    screen.PostEvent(Event::Custom);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    size_t index = find_task_index(target.id);
+    if (index >= tasks.size() && !show_completed)
+    {
+        // The match may be hidden with the completed tasks
+        show_completed = true;
+        refresh_tasks();
+        index = find_task_index(target.id);
+    }
 
-    if (db.delete_task(task.id))
+    if (index >= tasks.size())
     {
-        progress_value = 50;
-        screen.PostEvent(Event::Custom);
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        status_message = "Task \"" + target.description + "\" is not shown in the list.";
+        return;
+    }
+
+    selected_index = static_cast<int>(index);
+    status_message = "Found: " + target.description;
+}
+
+void TaskListView::start_tag_filter()
+{
+    tag_filter_input = format_tags(tag_filter);
+    current_view = "tag_filter";
+    status_message = "Filter by tags";
+}
+
+void TaskListView::apply_tag_filter_input()
+{
+    // Names are matched against the loaded tags; the database is not queried
+    unordered_map<string, int> ids_by_name;
+    for (const auto &[tag_id, name] : tag_names)
+    {
+        ids_by_name[name] = tag_id;
+    }
 
-        // Remove from cache
-        if (redis && redis->is_connected())
+    vector<int> tag_ids;
+    for (const auto &name : split_tag_names(tag_filter_input))
+    {
+        auto it = ids_by_name.find(name);
+        if (it == ids_by_name.end())
         {
-            redis->invalidate_task(task.id);
+            status_message = "No tag named #" + name + ".";
+            return;
         }
+        tag_ids.push_back(it->second);
+    }
 
-        progress_value = 100;
-        screen.PostEvent(Event::Custom);
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    current_view = "list";
+    set_tag_filter(tag_ids);
+    status_message = tag_ids.empty() ? "Tag filter cleared." : to_string(tasks.size()) + " task(s) tagged " + format_tags(tag_ids) + ".";
+}
+
+void TaskListView::submit_write(WriteBehindQueue::WriteJob job, function<void(bool)> on_done)
+{
+    // The callback comes from the writer thread; hand it to the UI thread
+    write_queue.submit(std::move(job), [this, on_done](bool ok)
+                        {
+        screen.Post([on_done, ok]
+                    { on_done(ok); });
+        screen.PostEvent(Event::Custom); });
+}
+
+void TaskListView::submit_task_save(const Task &task, bool is_edit)
+{
+    auto saved = std::make_shared<Task>(task);
+    vector<string> tag_list = split_tag_names(input_tags);
+    string link = input_link;
+
+    current_view = "list";
+    status_message = is_edit ? "Saving task..." : "Adding task...";
 
-        status_message = "Task deleted successfully!";
+    // Show an edit now, as far as it is known: tags that do not exist yet appear once the write commits.
+    // A new task needs its ID first, so it is added from the change feed.
+    bool patched = true;
+    if (is_edit)
+    {
+        Task shown = task;
+        shown.tags.clear();
+        for (const auto &name : tag_list)
+        {
+            auto known = std::find_if(tag_names.begin(), tag_names.end(), [&](const auto &tag)
+                                      { return tag.second == name; });
+            if (known != tag_names.end())
+            {
+                shown.tags.push_back(known->first);
+            }
+        }
+        std::sort(shown.tags.begin(), shown.tags.end());
+        if (!link.empty() && std::find(shown.links.begin(), shown.links.end(), link) == shown.links.end())
+        {
+            shown.links.push_back(link);
+        }
+        patched = patch_task_updated(selected_index, shown);
+    }
+
+    submit_write([saved, tag_list, link, is_edit](DatabaseManager &writer_db)
+                 {
+                     // Unknown tag names become new tags
+                     saved->tags.clear();
+                     for (const auto &name : tag_list)
+                     {
+                         int tag_id = writer_db.add_tag(name);
+                         if (tag_id < 0)
+                         {
+                             return false;
+                         }
+                         saved->tags.push_back(tag_id);
+                     }
+
+                     if (is_edit)
+                     {
+                         if (!writer_db.update_task(*saved))
+                         {
+                             return false;
+                         }
+                     }
+                     else
+                     {
+                         saved->id = writer_db.add_task(*saved);
+                         if (saved->id < 0)
+                         {
+                             return false;
+                         }
+                     }
+
+                     // Add link if provided and not already attached
+                     if (!link.empty() && std::find(saved->links.begin(), saved->links.end(), link) == saved->links.end())
+                     {
+                         if (!writer_db.add_task_link(saved->id, link))
+                         {
+                             return false;
+                         }
+                         saved->links.push_back(link);
+                     }
+                     return true; },
+                 [this, saved, is_edit](bool ok)
+                 {
+                     if (!ok)
+                     {
+                         status_message = is_edit ? "Failed to update task." : saved->is_subtask() ? "Failed to add subtask." : "Failed to add task.";
+                         if (is_edit)
+                         {
+                             refresh_tasks(); // Undo the edit shown in the list
+                         }
+                         return;
+                     }
+
+                     // Cache in Redis if available
+                     if (redis && redis->is_connected())
+                     {
+                         redis->cache_task(*saved);
+                     }
+
+                     // The list itself is patched from the change feed
+                     status_message = is_edit ? "Task updated successfully!" : saved->is_subtask() ? "Subtask added successfully!" : "Task added successfully!";
+                 });
+
+    if (!patched)
+    {
         refresh_tasks();
+    }
+}
 
-        // Force UI refresh
-        screen.PostEvent(Event::Custom);
+vector<string> TaskListView::split_tag_names(const string &names)
+{
+    vector<string> result;
+    string name;
+    auto flush = [&]()
+    {
+        if (!name.empty() && std::find(result.begin(), result.end(), name) == result.end())
+        {
+            result.push_back(name);
+        }
+        name.clear();
+    };
+
+    for (char c : names)
+    {
+        if (c == ',' || std::isspace(static_cast<unsigned char>(c)))
+        {
+            flush();
+        }
+        else if (c != '#' || !name.empty())
+        {
+            name += c;
+        }
     }
-    else
+    flush();
+
+    return result;
+}
+
+void TaskListView::delete_task_dialog()
+{
+    if (tasks.empty() || selected_index >= static_cast<int>(tasks.size()))
+    {
+        status_message = "No task selected.";
+        return;
+    }
+
+    current_view = "delete_confirm";
+    const Task &task = tasks[selected_index];
+    status_message = "Delete task: \"" + task.description + "\"? (y/N)";
+}
+
+void TaskListView::confirm_delete()
+{
+    if (tasks.empty() || selected_index >= static_cast<int>(tasks.size()))
     {
-        status_message = "Failed to delete task.";
+        current_view = "list";
+        status_message = "No task selected.";
+        return;
     }
 
-    show_progress = false;
+    const Task task = tasks[selected_index];
+
+    // Remove the task from the list now; the delete is written in the background
     current_view = "list";
-
-    // Final screen refresh
-    screen.PostEvent(Event::Custom);
+    status_message = "Task deleted successfully!";
+    bool patched = patch_task_removed(selected_index, true);
+
+    submit_write([task](DatabaseManager &writer_db)
+                 { return writer_db.delete_tasks({task.id}) >= 0; },
+                 [this](bool ok)
+                 {
+                     if (!ok)
+                     {
+                         status_message = "Failed to delete task.";
+                         refresh_tasks();
+                     }
+                 });
+
+    if (!patched)
+    {
+        refresh_tasks();
+    }
 }
 
 void TaskListView::save_task(bool is_edit)
@@ -778,12 +1838,6 @@ void TaskListView::save_task(bool is_edit)
         return;
     }
 
-    show_progress = true;
-    progress_value = 0;
-    progress_message = is_edit ? "Updating task..." : "Creating task...";
-    screen.PostEvent(Event::Custom);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
     Task task;
     if (is_edit && selected_index < static_cast<int>(tasks.size()))
     {
@@ -855,7 +1909,6 @@ void TaskListView::save_task(bool is_edit)
         {
             // Invalid format - show error
             status_message = "Invalid date format! Use: YYYY-MM-DD or YYYY-MM-DD HH:MM";
-            show_progress = false;
             return;
         }
     }
@@ -864,65 +1917,7 @@ void TaskListView::save_task(bool is_edit)
         task.due_date = std::nullopt;
     }
 
-    progress_value = 30;
-    screen.PostEvent(Event::Custom);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-    int result;
-    if (is_edit)
-    {
-        if (db.update_task(task))
-        {
-            result = task.id;
-        }
-        else
-        {
-            result = -1;
-        }
-    }
-    else
-    {
-        result = db.add_task(task);
-        task.id = result;
-    }
-
-    progress_value = 70;
-    screen.PostEvent(Event::Custom);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-    if (result > 0)
-    {
-        // Add link if provided
-        if (!input_link.empty())
-        {
-            db.add_task_link(task.id, input_link);
-        }
-
-        // Cache in Redis if available
-        if (redis && redis->is_connected())
-        {
-            redis->cache_task(task);
-        }
-
-        progress_value = 100;
-        screen.PostEvent(Event::Custom);
-
-        status_message = is_edit ? "Task updated successfully!" : "Task added successfully!";
-        refresh_tasks();
-
-        // Force UI refresh to update overdue status
-        screen.PostEvent(Event::Custom);
-    }
-    else
-    {
-        status_message = is_edit ? "Failed to update task." : "Failed to add task.";
-    }
-
-    show_progress = false;
-    current_view = "list";
-
-    // Final screen refresh to ensure overdue status is displayed
-    screen.PostEvent(Event::Custom);
+    submit_task_save(task, is_edit);
 }
 
 void TaskListView::save_subtask()
@@ -939,12 +1934,6 @@ void TaskListView::save_subtask()
         return;
     }
 
-    show_progress = true;
-    progress_value = 0;
-    progress_message = "Creating subtask...";
-    screen.PostEvent(Event::Custom);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
     Task subtask;
     subtask.created_at = time(nullptr);
     subtask.is_completed = false;
@@ -1004,7 +1993,6 @@ void TaskListView::save_subtask()
         else
         {
             status_message = "Invalid date format! Use: YYYY-MM-DD or YYYY-MM-DD HH:MM";
-            show_progress = false;
             return;
         }
     }
@@ -1013,46 +2001,7 @@ void TaskListView::save_subtask()
         subtask.due_date = std::nullopt;
     }
 
-    progress_value = 30;
-    screen.PostEvent(Event::Custom);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-    int result = db.add_task(subtask);
-    subtask.id = result;
-
-    progress_value = 70;
-    screen.PostEvent(Event::Custom);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-    if (result > 0)
-    {
-        // Add link if provided
-        if (!input_link.empty())
-        {
-            db.add_task_link(subtask.id, input_link);
-        }
-
-        // Cache in Redis if available
-        if (redis && redis->is_connected())
-        {
-            redis->cache_task(subtask);
-        }
-
-        progress_value = 100;
-        screen.PostEvent(Event::Custom);
-
-        status_message = "Subtask added successfully!";
-        refresh_tasks();
-        screen.PostEvent(Event::Custom);
-    }
-    else
-    {
-        status_message = "Failed to add subtask.";
-    }
-
-    show_progress = false;
-    current_view = "list";
-    screen.PostEvent(Event::Custom);
+    submit_task_save(subtask, false);
 }
 
 void TaskListView::show_ai_suggestions()
@@ -1069,14 +2018,10 @@ void TaskListView::show_ai_suggestions()
         return;
     }
 
-    current_view = "ai_suggestions";
-    const Task &task = tasks[selected_index];
-
-    status_message = "Getting AI suggestions...\n\n";
-    screen.PostEvent(Event::Custom); // Force refresh
-
-    string suggestions = ai.get_task_suggestions(task);
-    status_message = "AI Suggestions for: " + task.description + "\n\n" + suggestions;
+    const Task task = tasks[selected_index];
+    start_ai_job("AI Suggestions for: " + task.description,
+                 [this, task](const atomic<bool> *cancel, const TokenCallback &on_token)
+                 { return ai.get_task_suggestions(task, cancel, on_token); });
 }
 
 void TaskListView::show_schedule_summary()
@@ -1087,12 +2032,135 @@ void TaskListView::show_schedule_summary()
         return;
     }
 
+    if (!read_pool)
+    {
+        vector<Task> snapshot = tasks;
+        start_ai_job("Schedule Summary:",
+                     [this, snapshot](const atomic<bool> *cancel, const TokenCallback &on_token)
+                     { return ai.get_schedule_summary(snapshot, cancel, on_token); });
+        return;
+    }
+
+    // Load the tasks on the worker thread from a pooled connection, not the UI's
+    bool include_completed = show_completed;
+    start_ai_job("Schedule Summary:",
+                 [this, include_completed](const atomic<bool> *cancel, const TokenCallback &on_token)
+                 {
+                     vector<Task> snapshot;
+                     if (!read_pool->read([&](DatabaseManager &reader)
+                                          { snapshot = reader.get_all_tasks(include_completed); }))
+                     {
+                         return string("Error: Could not read tasks from the database.");
+                     }
+                     return ai.get_schedule_summary(snapshot, cancel, on_token); });
+}
+
+void TaskListView::start_ai_job(const string &title,
+                                function<string(const atomic<bool> *, const TokenCallback &)> request)
+{
+    // Only one request at a time. The previous one is cancelled and set aside
+    // rather than joined, so the UI never waits on it; its late results are
+    // dropped by job id.
+    cancel_ai_job();
+    if (ai_job.worker.joinable() || ai_job.ticker.joinable())
+    {
+        retired_ai_jobs.push_back(std::move(ai_job));
+    }
+    reap_ai_jobs();
+
+    unsigned job_id = ++ai_job_id;
+    auto cancel = std::make_shared<atomic<bool>>(false);
+    auto running = std::make_shared<atomic<int>>(2);
+    ai_job.cancel = cancel;
+    ai_job.running = running;
+    ai_busy = true;
+    ai_title = title;
     current_view = "ai_suggestions";
-    status_message = "Generating schedule summary...\n\n";
-    screen.PostEvent(Event::Custom); // Force refresh
+    status_message = title + "\n\n";
+
+    ai_job.worker = std::thread([this, job_id, cancel, running, request]
+                                {
+        // Streamed text is appended to the view as it arrives
+        auto on_token = [this, job_id, cancel](const string &piece)
+        {
+            screen.Post([this, job_id, cancel, piece]
+                        {
+                if (job_id != ai_job_id || *cancel)
+                {
+                    return;
+                }
+                status_message += piece;
+                screen.PostEvent(Event::Custom);
+            });
+        };
+
+        string result = request(cancel.get(), on_token);
+
+        // Hand the result to the UI thread; stale or cancelled jobs are dropped there
+        screen.Post([this, job_id, cancel, result]
+                    {
+            if (job_id != ai_job_id || *cancel)
+            {
+                return;
+            }
+            ai_busy = false;
+            status_message = ai_title + "\n\n" + result;
+            screen.PostEvent(Event::Custom);
+        });
+        --*running; });
+
+    // Keep the spinner moving while the worker waits on Ollama
+    ai_job.ticker = std::thread([this, cancel, running]
+                                {
+        while (ai_busy && !*cancel)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            screen.PostEvent(Event::Custom);
+        }
+        --*running; });
+}
+
+void TaskListView::cancel_ai_job()
+{
+    if (ai_job.cancel)
+    {
+        *ai_job.cancel = true;
+    }
+    ai_busy = false;
+}
+
+void TaskListView::stop_ai_job()
+{
+    cancel_ai_job();
+    retired_ai_jobs.push_back(std::move(ai_job));
+    for (auto &job : retired_ai_jobs)
+    {
+        if (job.worker.joinable())
+        {
+            job.worker.join();
+        }
+        if (job.ticker.joinable())
+        {
+            job.ticker.join();
+        }
+    }
+    retired_ai_jobs.clear();
+}
 
-    string summary = ai.get_schedule_summary(tasks);
-    status_message = "Schedule Summary:\n\n" + summary;
+void TaskListView::reap_ai_jobs()
+{
+    for (auto it = retired_ai_jobs.begin(); it != retired_ai_jobs.end();)
+    {
+        // A thread that has counted itself out is about to exit, so joining it is immediate
+        if (*it->running > 0)
+        {
+            ++it;
+            continue;
+        }
+        it->worker.join();
+        it->ticker.join();
+        it = retired_ai_jobs.erase(it);
+    }
 }
 
 void TaskListView::show_help()
@@ -1106,6 +2174,27 @@ void TaskListView::run()
 
     auto component = CatchEvent(main_container, [&](Event event)
                                 {
+        // Redraw requests (spinner ticks, background results) are not key presses
+        if (event == Event::Custom)
+        {
+            return false;
+        }
+
+        // Handle bulk delete confirmation
+        if (current_view == "bulk_delete_confirm")
+        {
+            if (event == Event::Character('y') || event == Event::Character('Y'))
+            {
+                confirm_bulk_delete();
+            }
+            else
+            {
+                current_view = "list";
+                status_message = "Delete cancelled.";
+            }
+            return true;
+        }
+
         // Handle delete confirmation
         if (current_view == "delete_confirm")
         {
@@ -1147,8 +2236,8 @@ void TaskListView::run()
             }
             else if (event == Event::Tab)
             {
-                // Cycle through fields: description -> due_date -> link -> progress -> status -> description
-                current_input_field = (current_input_field + 1) % 5;
+                // Cycle through fields: description -> due_date -> link -> progress -> status -> tags -> description
+                current_input_field = (current_input_field + 1) % 6;
                 return true;
             }
             else if (event == Event::Backspace)
@@ -1166,6 +2255,10 @@ void TaskListView::run()
                 {
                     input_link.pop_back();
                 }
+                else if (current_input_field == 5 && !input_tags.empty())
+                {
+                    input_tags.pop_back();
+                }
                 // Progress field doesn't need backspace (numeric only)
                 return true;
             }
@@ -1200,6 +2293,10 @@ void TaskListView::run()
                     {
                         input_link += '+';
                     }
+                    else if (current_input_field == 5)
+                    {
+                        input_tags += '+';
+                    }
                 }
                 return true;
             }
@@ -1234,6 +2331,10 @@ void TaskListView::run()
                     {
                         input_link += '-';
                     }
+                    else if (current_input_field == 5)
+                    {
+                        input_tags += '-';
+                    }
                 }
                 return true;
             }
@@ -1252,6 +2353,10 @@ void TaskListView::run()
                 {
                     input_link += event.character();
                 }
+                else if (current_input_field == 5)
+                {
+                    input_tags += event.character();
+                }
                 else if (current_input_field == 3)
                 {
                     // Progress field: only accept digits
@@ -1271,6 +2376,83 @@ void TaskListView::run()
             return true;
         }
         
+        // Handle search input; results follow every keystroke
+        if (current_view == "search")
+        {
+            if (event == Event::Escape)
+            {
+                current_view = "list";
+                status_message = "Search cancelled.";
+            }
+            else if (event == Event::Return)
+            {
+                open_search_result();
+            }
+            else if (event == Event::Tab && db.has_archive())
+            {
+                search_archive = !search_archive;
+                update_search();
+            }
+            else if (event == Event::ArrowUp)
+            {
+                search_selected = std::max(0, search_selected - 1);
+            }
+            else if (event == Event::ArrowDown)
+            {
+                search_selected = std::max(0, std::min(static_cast<int>(search_results.size()) - 1, search_selected + 1));
+            }
+            else if (event == Event::Backspace)
+            {
+                // Remove a whole UTF-8 character
+                while (!search_query.empty() && (static_cast<unsigned char>(search_query.back()) & 0xC0) == 0x80)
+                {
+                    search_query.pop_back();
+                }
+                if (!search_query.empty())
+                {
+                    search_query.pop_back();
+                }
+                update_search();
+            }
+            else if (event.is_character())
+            {
+                search_query += event.character();
+                update_search();
+            }
+            return true;
+        }
+
+        // Handle tag filter input
+        if (current_view == "tag_filter")
+        {
+            if (event == Event::Escape)
+            {
+                current_view = "list";
+                status_message = "Tag filter unchanged.";
+            }
+            else if (event == Event::Return)
+            {
+                apply_tag_filter_input();
+            }
+            else if (event == Event::Backspace)
+            {
+                // Remove a whole UTF-8 character
+                while (!tag_filter_input.empty() && (static_cast<unsigned char>(tag_filter_input.back()) & 0xC0) == 0x80)
+                {
+                    tag_filter_input.pop_back();
+                }
+                if (!tag_filter_input.empty())
+                {
+                    tag_filter_input.pop_back();
+                }
+            }
+            else if (event.is_character())
+            {
+                tag_filter_input += event.character();
+            }
+            return true;
+        }
+
         // Handle settings view
         if (current_view == "settings")
         {
@@ -1291,6 +2473,18 @@ void TaskListView::run()
             return true;
         }
         
+        // A running AI request keeps its view until it finishes or is cancelled
+        if (current_view == "ai_suggestions" && ai_busy)
+        {
+            if (event == Event::Escape)
+            {
+                cancel_ai_job();
+                current_view = "list";
+                status_message = "AI request cancelled.";
+            }
+            return true;
+        }
+
         // Handle other views (help, AI suggestions)
         if (current_view != "list")
         {
@@ -1317,7 +2511,14 @@ void TaskListView::run()
         }
         else if (event == Event::Character('d'))
         {
-            delete_task_dialog();
+            if (!marked_task_ids.empty())
+            {
+                bulk_delete_dialog();
+            }
+            else
+            {
+                delete_task_dialog();
+            }
             return true;
         }
         else if (event == Event::Character('t'))
@@ -1327,7 +2528,24 @@ void TaskListView::run()
         }
         else if (event == Event::Character(' '))
         {
-            toggle_task_completion();
+            if (!marked_task_ids.empty())
+            {
+                toggle_marked_completion();
+            }
+            else
+            {
+                toggle_task_completion();
+            }
+            return true;
+        }
+        else if (event == Event::Character('m'))
+        {
+            toggle_task_mark();
+            return true;
+        }
+        else if (event == Event::Character('M'))
+        {
+            clear_task_marks();
             return true;
         }
         else if (event == Event::Character('s'))
@@ -1350,6 +2568,11 @@ void TaskListView::run()
             sync_to_sheets();
             return true;
         }
+        else if (event == Event::Character('b'))
+        {
+            start_backup();
+            return true;
+        }
         else if (event == Event::Character('c'))
         {
             show_completed = !show_completed;
@@ -1362,6 +2585,16 @@ void TaskListView::run()
             show_help();
             return true;
         }
+        else if (event == Event::Character('/'))
+        {
+            start_search();
+            return true;
+        }
+        else if (event == Event::Character('#'))
+        {
+            start_tag_filter();
+            return true;
+        }
         else if (event == Event::ArrowUp)
         {
             if (selected_index > 0)
@@ -1378,6 +2611,26 @@ void TaskListView::run()
             }
             return true;
         }
+        else if (event == Event::PageUp)
+        {
+            selected_index = std::max(0, selected_index - visible_task_rows());
+            return true;
+        }
+        else if (event == Event::PageDown)
+        {
+            selected_index = std::max(0, std::min(static_cast<int>(tasks.size()) - 1, selected_index + visible_task_rows()));
+            return true;
+        }
+        else if (event == Event::Home)
+        {
+            selected_index = 0;
+            return true;
+        }
+        else if (event == Event::End)
+        {
+            selected_index = tasks.empty() ? 0 : static_cast<int>(tasks.size()) - 1;
+            return true;
+        }
 
         return false; });
 
@@ -1404,6 +2657,7 @@ void TaskListView::edit_task_dialog()
     input_link = task.links.empty() ? "" : task.links[0];
     input_progress = task.progress;
     input_status = task.status;
+    input_tags = format_tags(task.tags, ", ");
     current_input_field = 0;
 
     current_view = "edit";
@@ -1431,6 +2685,7 @@ void TaskListView::add_subtask_dialog()
     input_due_date = "";
     input_link = "";
     input_progress = 0;
+    input_tags = "";
     current_input_field = 0;
 
     current_view = "add_subtask";
@@ -1482,3 +2737,41 @@ void TaskListView::sync_to_sheets()
     // show_progress = false;
     // screen.PostEvent(Event::Custom);
 }
+
+void TaskListView::start_backup()
+{
+    if (!backup)
+    {
+        status_message = "Backups are not configured.";
+        return;
+    }
+
+    // Progress and the result arrive on the backup thread
+    bool started = backup->start(
+        [this](const string &stage, int percent)
+        {
+            screen.Post([this, stage, percent]
+                        {
+                progress_message = stage + " backup...";
+                progress_value = percent; });
+            screen.PostEvent(Event::Custom);
+        },
+        [this](bool ok, const string &result)
+        {
+            screen.Post([this, ok, result]
+                        {
+                show_progress = false;
+                status_message = ok ? "Backup written to " + result : "Backup failed: " + result; });
+            screen.PostEvent(Event::Custom);
+        });
+    if (!started)
+    {
+        status_message = "A backup is already running.";
+        return;
+    }
+
+    show_progress = true;
+    progress_value = 0;
+    progress_message = "Copying backup...";
+    status_message = "Backing up the database; you can keep working.";
+}
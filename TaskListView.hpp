@@ -1,45 +1,170 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "ftxui/component/component.hpp"
 #include "ftxui/component/screen_interactive.hpp"
 #include "DatabaseManager.hpp"
 #include "AIAssistant.hpp"
+#include "DatabaseBackup.hpp"
 #include "RedisManager.hpp"
+#include "TagIndex.hpp"
+#include "ReadConnectionPool.hpp"
 #include "Task.hpp"
+#include "WriteBehindQueue.hpp"
 
+using std::atomic;
+using std::function;
 using std::string;
+using std::unordered_map;
+using std::unordered_set;
 using std::vector;
 
 class TaskListView
 {
 public:
-    TaskListView(DatabaseManager &db_manager, AIAssistant &ai_assistant, RedisManager *redis_manager = nullptr);
+    /**
+     * @param db_manager Connection used for reads; the view never writes through it
+     * @param ai_assistant AI backend
+     * @param write_queue Background writer that commits every write of the view, so
+     *        a watcher reading its data version never mistakes them for foreign commits
+     * @param redis_manager Optional task cache
+     * @param read_pool Optional read-only connections for background threads
+     * @param backup Optional online backup, started with 'b'
+     */
+    TaskListView(DatabaseManager &db_manager, AIAssistant &ai_assistant, WriteBehindQueue &write_queue,
+                 RedisManager *redis_manager = nullptr, ReadConnectionPool *read_pool = nullptr,
+                 DatabaseBackup *backup = nullptr);
+
+    /**
+     * @brief Destructor - cancels and joins any running AI request or backup
+     */
+    ~TaskListView();
 
     /**
      * @brief Run the main application loop
      */
     void run();
 
+    /**
+     * @brief Reload the list after another process changed the database
+     * Safe to call from any thread; the reload runs on the UI thread.
+     */
+    void notify_external_changes();
+
 private:
     /**
      * @brief Refresh task list from database
+     * Reads one snapshot without waiting for queued writes; those are patched
+     * in from the change feed when they commit.
      */
     void refresh_tasks();
 
     /**
-     * @brief Create the main UI layout
-     * @return FTXUI component
+     * @brief Narrow the freshly loaded list to tasks matching the tag filter
+     * Uses the in-memory tag index; the full list is kept aside in unfiltered_tasks.
      */
-    ftxui::Component create_ui();
+    void filter_loaded_tasks();
+
+    /**
+     * @brief Change the tag filter without reloading from the database
+     * @param tag_ids Tags every shown task must have; empty shows all tasks
+     */
+    void set_tag_filter(const vector<int> &tag_ids);
+
+    /**
+     * @brief Insert a newly created task into the loaded list without reloading
+     * @param task The task as stored in the database
+     * @return false if the list could not be patched and needs a full refresh
+     */
+    bool patch_task_inserted(const Task &task);
+
+    /**
+     * @brief Replace a loaded task after an update, moving it if its sort key changed
+     * @param index Position of the task in the list
+     * @param task The task as stored in the database
+     * @return false if the list could not be patched and needs a full refresh
+     */
+    bool patch_task_updated(size_t index, const Task &task);
+
+    /**
+     * @brief Remove a task and the subtasks shown under it from the loaded list
+     * @param index Position of the task in the list
+     * @param deleted true if the task was deleted (updates subtask counts)
+     * @return false if the list could not be patched and needs a full refresh
+     */
+    bool patch_task_removed(size_t index, bool deleted);
+
+    /**
+     * @brief Bring the loaded list up to date with committed task changes
+     * Changed rows are re-read and patched in place; falls back to a full
+     * refresh when a change cannot be placed.
+     * @param changes Changes published by the writing connection
+     */
+    void apply_task_changes(const vector<TaskChange> &changes);
+
+    /**
+     * @brief Patch the loaded list with committed task changes
+     * @param changes The changes, oldest first
+     * @param rows Current rows of changed tasks that are already loaded; the
+     *             other inserted or updated tasks are read from the database
+     */
+    void patch_task_changes(const vector<TaskChange> &changes, const unordered_map<int, Task> &rows);
+
+    /**
+     * @brief Apply the tasks changed since change_mark, e.g. by another process
+     * Reads only the changed rows (updated_at and tombstones), not the whole list,
+     * and patches from those rows directly. Rows this view has already seen
+     * unchanged are skipped.
+     */
+    void load_external_changes();
+
+    /**
+     * @brief Get the position just past a task's subtree in the list
+     * @param index Position of the task in the list
+     * @return Index of the first row that is not a descendant of the task
+     */
+    size_t subtree_end(size_t index) const;
+
+    /**
+     * @brief Find where a task belongs among its siblings
+     * @param task The task to place
+     * @param begin First row of the sibling range
+     * @param end One past the last row of the sibling range
+     * @param depth Nesting depth of the siblings
+     * @return Insertion index within [begin, end]
+     */
+    size_t sibling_position(const Task &task, size_t begin, size_t end, int depth) const;
 
     /**
-     * @brief Create the task list display component
+     * @brief Apply a change to the cached subtask counts of a task's parent
+     * @param task The subtask that changed (ignored for top-level tasks)
+     * @param total_delta Change in the parent's subtask total
+     * @param completed_delta Change in the parent's completed subtask count
+     */
+    void adjust_subtask_counts(const Task &task, int total_delta, int completed_delta);
+
+    /**
+     * @brief Check whether task a is listed before task b in the task query order
+     */
+    static bool sorts_before(const Task &a, const Task &b);
+
+    /**
+     * @brief Check whether a task counts as completed in subtask totals
+     */
+    static bool counts_as_done(const Task &task);
+
+    /**
+     * @brief Create the main UI layout
      * @return FTXUI component
      */
-    ftxui::Component create_task_list();
+    ftxui::Component create_ui();
 
     /**
      * @brief Create the menu/command bar component
@@ -47,6 +172,100 @@ private:
      */
     ftxui::Component create_menu();
 
+    /**
+     * @brief Build the task rows that fall inside the list viewport
+     * Rows outside the scroll window are never formatted.
+     * @return Elements for the visible rows
+     */
+    ftxui::Elements render_task_rows();
+
+    /**
+     * @brief Formatted row for a task, reused across frames while the task is unchanged
+     */
+    struct RowCacheEntry
+    {
+        unsigned long long version = 0; // row_versions stamp the row was built from
+        int depth = 0;                  // Nesting depth the row was built for
+        bool overdue = false;           // Overdue state the row was built for
+        string text;                    // Output of format_task
+        ftxui::Element element;         // Styled element for an unselected row
+    };
+
+    /**
+     * @brief A scrolling panel whose height is read back from its last layout
+     */
+    struct PanelLayout
+    {
+        ftxui::Box box;      // Filled by ftxui::reflect when the panel is laid out
+        int screen_rows = 0; // Terminal height the box was laid out for; 0 before the first layout
+    };
+
+    /**
+     * @brief Threads of one AI request and the flags they share
+     */
+    struct AIJob
+    {
+        std::thread worker;                    // Runs the Ollama request
+        std::thread ticker;                    // Redraws the spinner while the request runs
+        std::shared_ptr<atomic<bool>> cancel;  // Set to abort this request
+        std::shared_ptr<atomic<int>> running;  // Threads of this request that have not finished
+    };
+
+    /**
+     * @brief Get the formatted row for a task, rebuilding it only if the task changed
+     * @param index Position of the task in the list
+     * @return Cached row entry
+     */
+    const RowCacheEntry &cached_row(size_t index);
+
+    /**
+     * @brief Mark a task's row as changed so it is formatted again on the next frame
+     * @param task_id The ID of the task
+     */
+    void invalidate_row(int task_id);
+
+    /**
+     * @brief Number of rows that fit in a scrolling panel
+     * @param panel The panel's last layout
+     * @param chrome_rows Lines the rest of the view takes; only used before the first layout
+     * @return Row count from the last layout, adjusted for any resize since
+     */
+    int panel_rows(const PanelLayout &panel, int chrome_rows) const;
+
+    /**
+     * @brief Size a panel for the frame being built
+     * Reads the rows from the previous layout, then records the terminal height
+     * the box will be filled for by this frame's layout.
+     * @param panel The panel about to be rendered with reflect(panel.box)
+     * @param chrome_rows Lines the rest of the view takes; only used before the first layout
+     * @return Rows to render
+     */
+    int begin_panel(PanelLayout &panel, int chrome_rows);
+
+    /**
+     * @brief Number of task rows that fit in the list panel
+     * @return Row count from the panel's last layout, adjusted for any resize since
+     */
+    int visible_task_rows() const;
+
+    /**
+     * @brief Recompute the completed task count shown in the status bar
+     * Only needed after a full reload; patches adjust the count themselves.
+     */
+    void recount_completed();
+
+    /**
+     * @brief Take the position of every listed task again
+     */
+    void rebuild_task_positions();
+
+    /**
+     * @brief Find a task in the list by ID
+     * @param task_id The ID of the task
+     * @return Its index in tasks, or tasks.size() if it is not listed
+     */
+    size_t find_task_index(int task_id);
+
     /**
      * @brief Render the current UI state
      * @return FTXUI element
@@ -89,6 +308,90 @@ private:
      */
     void toggle_task_completion();
 
+    /**
+     * @brief Mark or unmark the selected task for bulk actions and move to the next row
+     */
+    void toggle_task_mark();
+
+    /**
+     * @brief Unmark all tasks
+     */
+    void clear_task_marks();
+
+    /**
+     * @brief Complete all marked tasks, or reopen them if all are already completed
+     */
+    void toggle_marked_completion();
+
+    /**
+     * @brief Ask for confirmation before deleting the marked tasks
+     */
+    void bulk_delete_dialog();
+
+    /**
+     * @brief Delete all marked tasks and their subtasks
+     */
+    void confirm_bulk_delete();
+
+    /**
+     * @brief Enter search mode with an empty query
+     */
+    void start_search();
+
+    /**
+     * @brief Run the current search query and reset the result selection
+     */
+    void update_search();
+
+    /**
+     * @brief Leave search mode and select the chosen result in the task list
+     * Archived results cannot be selected; their description is shown instead.
+     */
+    void open_search_result();
+
+    /**
+     * @brief Open the tag filter prompt, prefilled with the active filter
+     */
+    void start_tag_filter();
+
+    /**
+     * @brief Apply the tag names typed in the filter prompt
+     */
+    void apply_tag_filter_input();
+
+    /**
+     * @brief Format tag IDs as "#name" words
+     * @param tag_ids The tag IDs
+     * @param separator Text between names
+     * @return The names, or an empty string if there are none
+     */
+    string format_tags(const vector<int> &tag_ids, const string &separator = " ") const;
+
+    /**
+     * @brief Write to the database without blocking the UI thread
+     * Goes through the write queue when there is one; on_done then runs on the
+     * UI thread after the write is committed. Otherwise both run immediately.
+     * @param job The write, given the connection to use
+     * @param on_done Receives whether the write was committed
+     */
+    void submit_write(WriteBehindQueue::WriteJob job, function<void(bool)> on_done);
+
+    /**
+     * @brief Queue a task (or subtask) save with the dialog's tags and link
+     * An edit is shown in the list right away and undone if the write fails;
+     * a new task is added to the list once the write is committed.
+     * @param task The task built from the dialog fields
+     * @param is_edit true to update an existing task, false to add it
+     */
+    void submit_task_save(const Task &task, bool is_edit);
+
+    /**
+     * @brief Split user input into tag names
+     * @param names Names separated by commas or whitespace, optionally prefixed with '#'
+     * @return Distinct names in input order
+     */
+    static vector<string> split_tag_names(const string &names);
+
     /**
      * @brief Show AI suggestions for selected task
      */
@@ -99,6 +402,32 @@ private:
      */
     void show_schedule_summary();
 
+    /**
+     * @brief Run an AI request on a background thread and show its result when done
+     * The UI stays responsive; a spinner is shown until the response is complete.
+     * Streamed text is shown as it arrives and replaced by the final result.
+     * @param title Heading shown above the result
+     * @param request Produces the AI text; must stop early once the flag it gets is set,
+     *                and may report partial text through the callback it gets
+     */
+    void start_ai_job(const string &title,
+                      function<string(const atomic<bool> *, const TokenCallback &)> request);
+
+    /**
+     * @brief Ask the running AI request to stop without waiting for it
+     */
+    void cancel_ai_job();
+
+    /**
+     * @brief Cancel the running AI request and wait for the threads of every request to finish
+     */
+    void stop_ai_job();
+
+    /**
+     * @brief Join the threads of replaced AI requests that have already finished; never blocks
+     */
+    void reap_ai_jobs();
+
     /**
      * @brief Export tasks to Google Sheets
      */
@@ -119,6 +448,11 @@ private:
      */
     void sync_to_sheets();
 
+    /**
+     * @brief Start an online backup of the database, shown in the progress bar
+     */
+    void start_backup();
+
     /**
      * @brief Show help dialog
      */
@@ -127,10 +461,11 @@ private:
     /**
      * @brief Format a task for display
      * @param task The task to format
+     * @param depth Subtask nesting depth (0 for top-level tasks)
      * @param is_selected Whether the task is currently selected
      * @return Formatted string
      */
-    string format_task(const Task &task, bool is_selected) const;
+    string format_task(const Task &task, int depth, bool is_selected) const;
 
     /**
      * @brief Format detailed task information for the details panel
@@ -142,19 +477,76 @@ private:
     // References and pointers
     DatabaseManager &db;
     AIAssistant &ai;
+    WriteBehindQueue &write_queue;
     RedisManager *redis;
+    ReadConnectionPool *read_pool;
+    DatabaseBackup *backup;
+    int change_subscription; // Listener on the writing connection's change feed
+    int64_t change_mark;     // Changes up to here are in the list (see get_tasks_changed_since)
+    unordered_map<int, Task> delta_rows;  // Rows of the last external delta as read; cleared on reload
+    unordered_set<int> delta_deleted_ids; // Deletions of the last external delta
 
     // UI state
     ftxui::ScreenInteractive screen;
     vector<Task> tasks;
+    vector<int> task_depths; // Nesting depth of each entry in tasks
+    unordered_map<int, SubtaskCounts> subtask_counts; // Parent ID -> subtask counts, loaded with tasks
     int selected_index;
     bool show_completed;
     string status_message;
-    string current_view; // "list", "add", "edit", "help", "ai_suggestions", "delete_confirm"
+    string current_view; // "list", "add", "edit", "help", "ai_suggestions", "delete_confirm", "bulk_delete_confirm", "search", "tag_filter"
     bool show_progress;
     int progress_value;
     string progress_message;
 
+    // Details panel text for the selected task, rebuilt when the selection or data changes
+    int details_task_id;
+    string details_text;
+
+    // List viewport
+    static constexpr int LIST_CHROME_ROWS = 12;   // Header, command bar, status bar and list border
+    static constexpr int SEARCH_CHROME_ROWS = 13; // Header, query box, help line, status bar and results border
+    static constexpr int ROW_OVERSCAN = 3;        // Rows built on each side of the window, out of view
+    PanelLayout task_list_layout;                 // The list panel
+    PanelLayout search_layout;                    // The search results panel
+    int scroll_offset;                            // Index of the first visible row
+    int completed_task_count;                     // Completed entries in tasks
+    unordered_map<int, size_t> task_positions; // Task ID -> index in tasks; an index may be stale, never an ID
+
+    // Larger commits are cheaper to apply with a full refresh than row by row
+    static constexpr size_t MAX_PATCHED_CHANGES = 256;
+
+    // Task IDs marked for bulk actions; only tasks present in the list stay marked
+    unordered_set<int> marked_task_ids;
+
+    // Live search ('/')
+    static constexpr int SEARCH_RESULT_LIMIT = 200;
+    string search_query;
+    vector<Task> search_results;   // Best match first; archive matches follow the list matches
+    size_t archived_results_start; // Index of the first archive match
+    bool search_archive;           // Tab: also search the archive database
+    int search_selected;
+
+    // Tags; filtering ('#') runs on the in-memory index, not the database
+    unordered_map<int, string> tag_names; // Tag ID -> name
+    TagIndex tag_index;                   // Covers the full loaded list
+    vector<int> tag_filter;               // Shown tasks have all of these tags; empty for no filter
+    vector<Task> unfiltered_tasks;        // Full list while a filter is active
+    vector<int> unfiltered_depths;        // Nesting depths for unfiltered_tasks
+    string tag_filter_input;
+
+    // Row render cache, keyed by task ID and checked against the task's version stamp
+    unordered_map<int, RowCacheEntry> row_cache;
+    unordered_map<int, unsigned long long> row_versions; // Task ID -> version, bumped on change
+    unsigned long long row_generation;                   // Source of version stamps
+
+    // Background AI request
+    AIJob ai_job;                  // The current request
+    vector<AIJob> retired_ai_jobs; // Replaced requests still winding down
+    atomic<bool> ai_busy;          // true until the result is shown or the request is cancelled
+    unsigned ai_job_id;            // Identifies the current request; older results are dropped
+    string ai_title;               // Heading for the current request's result
+
     // Input fields
     string input_description;
     int input_priority;
@@ -162,5 +554,6 @@ private:
     string input_link;
     int input_progress;
     int input_status;
-    int current_input_field; // 0=description, 1=due_date, 2=link, 3=progress, 4=status
+    string input_tags;
+    int current_input_field; // 0=description, 1=due_date, 2=link, 3=progress, 4=status, 5=tags
 };
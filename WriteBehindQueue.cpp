@@ -0,0 +1,155 @@
+#include "WriteBehindQueue.hpp"
+#include <iostream>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+using std::exception;
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+using std::vector;
+
+WriteBehindQueue::WriteBehindQueue(const string &db_path, const SqliteProfile &profile,
+                                   std::chrono::milliseconds commit_window, size_t max_batch)
+    : db(db_path, profile), commit_window(commit_window), max_batch(max_batch > 0 ? max_batch : 1),
+      writing(false), stopping(false), flush_waiters(0), committed_batches(0), completed_jobs(0)
+{
+    worker = std::thread([this]
+                         { run(); });
+}
+
+WriteBehindQueue::~WriteBehindQueue()
+{
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+void WriteBehindQueue::submit(WriteJob job, WriteCallback on_done)
+{
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        queue.push_back(PendingWrite{std::move(job), std::move(on_done)});
+    }
+    wake.notify_one();
+}
+
+void WriteBehindQueue::flush()
+{
+    unique_lock<mutex> lock(queue_mutex);
+    flush_waiters++;
+    wake.notify_one();
+    idle.wait(lock, [&]
+              { return queue.empty() && !writing; });
+    flush_waiters--;
+}
+
+int WriteBehindQueue::subscribe_changes(DatabaseManager::TaskChangeListener listener)
+{
+    return db.subscribe_changes(std::move(listener));
+}
+
+void WriteBehindQueue::unsubscribe_changes(int subscription)
+{
+    db.unsubscribe_changes(subscription);
+}
+
+long long WriteBehindQueue::get_data_version()
+{
+    // The writer thread only uses its connection while writing is set, which needs this lock
+    unique_lock<mutex> lock(queue_mutex);
+    idle.wait(lock, [&]
+              { return !writing; });
+    return db.get_data_version();
+}
+
+long long WriteBehindQueue::get_committed_batches() const
+{
+    lock_guard<mutex> lock(queue_mutex);
+    return committed_batches;
+}
+
+long long WriteBehindQueue::get_completed_jobs() const
+{
+    lock_guard<mutex> lock(queue_mutex);
+    return completed_jobs;
+}
+
+void WriteBehindQueue::run()
+{
+    unique_lock<mutex> lock(queue_mutex);
+
+    while (true)
+    {
+        wake.wait(lock, [&]
+                  { return stopping || !queue.empty(); });
+        if (queue.empty())
+        {
+            break; // Stopping with nothing left to write
+        }
+
+        // Group commit: let a burst of jobs join this transaction
+        auto deadline = std::chrono::steady_clock::now() + commit_window;
+        wake.wait_until(lock, deadline, [&]
+                        { return stopping || flush_waiters > 0 || queue.size() >= max_batch; });
+
+        std::deque<PendingWrite> batch;
+        while (!queue.empty() && batch.size() < max_batch)
+        {
+            batch.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+        writing = true;
+
+        lock.unlock();
+        commit_batch(batch);
+        lock.lock();
+
+        writing = false;
+        committed_batches++;
+        completed_jobs += static_cast<long long>(batch.size());
+        idle.notify_all();
+    }
+
+    idle.notify_all();
+}
+
+void WriteBehindQueue::commit_batch(std::deque<PendingWrite> &batch)
+{
+    vector<bool> results(batch.size(), false);
+
+    // Each job runs in its own savepoint, so a failing job does not undo the others
+    bool committed = db.run_in_transaction([&]()
+                                           {
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            results[i] = db.run_in_transaction([&]()
+                                               { return batch[i].job(db); });
+        }
+        return true; });
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        if (!batch[i].on_done)
+        {
+            continue;
+        }
+
+        try
+        {
+            batch[i].on_done(committed && results[i]);
+        }
+        catch (const exception &e)
+        {
+            cerr << "Error in write callback: " << e.what() << endl;
+        }
+    }
+}
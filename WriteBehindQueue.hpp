@@ -0,0 +1,136 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "DatabaseManager.hpp"
+#include "SqliteProfile.hpp"
+
+using std::function;
+using std::string;
+
+/**
+ * @brief Applies database writes on a background thread
+ * The writer thread owns its own connection. Jobs submitted within a short
+ * window are committed together in one transaction (group commit), each in
+ * its own savepoint, and every job's callback is invoked after the commit.
+ */
+class WriteBehindQueue
+{
+public:
+    /**
+     * @brief A write to run on the writer connection; return false to undo it
+     */
+    using WriteJob = function<bool(DatabaseManager &)>;
+
+    /**
+     * @brief Called on the writer thread once the job's batch is committed
+     * The argument is true if the job succeeded and its changes are durable.
+     */
+    using WriteCallback = function<void(bool)>;
+
+    /**
+     * @brief Open the writer connection and start the writer thread
+     * The schema must already be initialized.
+     * @param db_path The database file
+     * @param profile Connection settings (WAL lets the UI connection read while writes commit)
+     * @param commit_window How long the first job of a batch waits for more jobs to join it
+     * @param max_batch Maximum number of jobs per transaction
+     */
+    WriteBehindQueue(const string &db_path, const SqliteProfile &profile = SqliteProfile(),
+                     std::chrono::milliseconds commit_window = std::chrono::milliseconds(5),
+                     size_t max_batch = 256);
+
+    /**
+     * @brief Commit every queued job and stop the writer thread
+     */
+    ~WriteBehindQueue();
+
+    WriteBehindQueue(const WriteBehindQueue &) = delete;
+    WriteBehindQueue &operator=(const WriteBehindQueue &) = delete;
+
+    /**
+     * @brief Queue a write; returns immediately
+     * @param job The write, run on the writer thread
+     * @param on_done Optional completion callback, run on the writer thread
+     */
+    void submit(WriteJob job, WriteCallback on_done = nullptr);
+
+    /**
+     * @brief Wait until every job submitted so far is committed
+     * Skips the rest of the current commit window.
+     */
+    void flush();
+
+    /**
+     * @brief Listen for task changes committed by the writer
+     * The listener runs on the writer thread after each commit.
+     * @param listener Receives each commit's changes
+     * @return Subscription ID for unsubscribe_changes
+     */
+    int subscribe_changes(DatabaseManager::TaskChangeListener listener);
+
+    /**
+     * @brief Stop listening for task changes
+     * @param subscription ID returned by subscribe_changes
+     */
+    void unsubscribe_changes(int subscription);
+
+    /**
+     * @brief Read PRAGMA data_version on the writer connection
+     * Since every write of this process goes through the writer, a changed
+     * value means another process committed. Waits for a batch in progress.
+     * @return The data version, or -1 on error
+     */
+    long long get_data_version();
+
+    /**
+     * @brief Get the number of committed transactions
+     * @return Batch count
+     */
+    long long get_committed_batches() const;
+
+    /**
+     * @brief Get the number of jobs that have completed (successfully or not)
+     * @return Job count
+     */
+    long long get_completed_jobs() const;
+
+private:
+    struct PendingWrite
+    {
+        WriteJob job;
+        WriteCallback on_done;
+    };
+
+    /**
+     * @brief Writer thread: collect batches and commit them until stopped
+     */
+    void run();
+
+    /**
+     * @brief Run a batch in one transaction and report each job's result
+     * @param batch The jobs, in submission order
+     */
+    void commit_batch(std::deque<PendingWrite> &batch);
+
+    DatabaseManager db;
+    std::chrono::milliseconds commit_window;
+    size_t max_batch;
+
+    mutable std::mutex queue_mutex;
+    std::condition_variable wake; // New job, flush request or stop
+    std::condition_variable idle; // A batch finished
+    std::deque<PendingWrite> queue;
+    bool writing;      // A batch is being committed
+    bool stopping;     // Drain the queue and exit
+    int flush_waiters; // Callers blocked in flush(); cuts the commit window short
+    long long committed_batches;
+    long long completed_jobs;
+
+    std::thread worker; // Started last, after every member it uses
+};
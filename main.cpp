@@ -1,13 +1,19 @@
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <thread>
 #include <chrono>
+#include <ctime>
 
 #include "ConfigManager.hpp"
 #include "DatabaseManager.hpp"
 #include "RedisManager.hpp"
 #include "AIAssistant.hpp"
 #include "TaskListView.hpp"
+#include "DatabaseBackup.hpp"
+#include "DatabaseWatcher.hpp"
+#include "ReadConnectionPool.hpp"
+#include "WriteBehindQueue.hpp"
 
 using std::cerr;
 using std::cout;
@@ -28,7 +34,7 @@ int main()
         }
 
         // Initialize database
-        DatabaseManager db(config.get_database_path());
+        DatabaseManager db(config.get_database_path(), config.get_database_profile());
         db.initilize_database();
 
         // Initialize Redis (optional)
@@ -47,6 +53,52 @@ int main()
             }
         }
 
+        // Writes from the UI are committed on a background connection
+        WriteBehindQueue write_queue(config.get_database_path(), config.get_database_profile());
+
+        // Cached tasks are dropped as soon as a change to them commits
+        if (redis)
+        {
+            RedisManager *cache = redis.get();
+            write_queue.subscribe_changes([cache](const vector<TaskChange> &changes)
+                                          { cache->invalidate_changes(changes); });
+        }
+
+        // Move long-completed tasks out of the task list; the archive stays attached for search.
+        // Archiving publishes the moved tasks as deletions, which drops their cached copies.
+        if (config.is_archive_enabled() && db.attach_archive(config.get_archive_path()))
+        {
+            int cache_subscription = -1;
+            if (redis)
+            {
+                RedisManager *cache = redis.get();
+                cache_subscription = db.subscribe_changes([cache](const vector<TaskChange> &changes)
+                                                          { cache->invalidate_changes(changes); });
+            }
+
+            time_t cutoff = std::time(nullptr) - static_cast<time_t>(std::max(0, config.get_archive_after_days())) * 24 * 60 * 60;
+            int archived = db.archive_completed_tasks(cutoff);
+            if (archived > 0)
+            {
+                cout << "Archived " << archived << " completed task(s)." << endl;
+            }
+
+            if (redis)
+            {
+                db.unsubscribe_changes(cache_subscription);
+            }
+        }
+
+        // Deletions older than any reload mark no longer need their tombstones
+        db.prune_tombstones();
+
+        // A database first opened by a build without FTS5 gets its search index now
+        db.ensure_full_text_search();
+
+        // Background readers get their own read-only connections
+        ReadConnectionPool read_pool(config.get_database_path(), config.get_database_profile(),
+                                     static_cast<size_t>(std::max(0, config.get_read_connections())));
+
         // Initialize AI Assistant
         AIAssistant ai(config);
         if (ai.is_available())
@@ -58,8 +110,31 @@ int main()
             cout << "AI features are disabled." << endl;
         }
 
+        // Online backups run on their own connection and thread, and take the archive along
+        DatabaseBackup backup(config.get_database_path(), config.get_backup_settings(),
+                              db.has_archive() ? config.get_archive_path() : "");
+        if (config.get_backup_settings().compress && !DatabaseBackup::compression_available())
+        {
+            cout << "Warning: Built without zstd, backups are stored uncompressed." << endl;
+        }
+
         // Create and run the UI
-        TaskListView view(db, ai, redis.get());
+        TaskListView view(db, ai, write_queue, redis.get(), &read_pool, &backup);
+
+        // Pick up commits from other processes; stopped before the view is destroyed.
+        // The view writes only through write_queue, so its data version moves only for foreign commits.
+        unique_ptr<DatabaseWatcher> watcher;
+        if (config.get_watch_interval_ms() > 0)
+        {
+            watcher = make_unique<DatabaseWatcher>(
+                config.get_database_path(),
+                [&write_queue]()
+                { return write_queue.get_data_version(); },
+                [&view]()
+                { view.notify_external_changes(); },
+                std::chrono::milliseconds(config.get_watch_interval_ms()));
+        }
+
         view.run();
 
         cout << "Thank you for using Teminder!" << endl;